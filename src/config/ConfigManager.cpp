@@ -55,7 +55,11 @@ ConfigManager::ConnectionConfig ConfigManager::getConnectionConfig() const {
             3,           // Domyślne wartości dla pozostałych parametrów
             5000,
             1000,
-            5000
+            5000,
+            false,       // Sieć w wątku GUI
+            262144,      // Górny próg backpressure zapisu
+            65536,       // Dolny próg backpressure zapisu
+            false        // Tylko JSON
         };
     }
 
@@ -66,6 +70,10 @@ ConfigManager::ConnectionConfig ConfigManager::getConnectionConfig() const {
     config.reconnectDelay = settings->value("ConnectionSettings/reconnectDelay", 5000).toInt();
     config.pingInterval = settings->value("ConnectionSettings/pingInterval", 1000).toInt();
     config.connectionTimeout = settings->value("ConnectionSettings/connectionTimeout", 5000).toInt();
+    config.useNetworkThread = settings->value("ConnectionSettings/networkThread", false).toBool();
+    config.writeHighWatermark = settings->value("ConnectionSettings/writeHighWatermark", 262144).toLongLong();
+    config.writeLowWatermark = settings->value("ConnectionSettings/writeLowWatermark", 65536).toLongLong();
+    config.preferCbor = settings->value("ConnectionSettings/wireFormat", "json").toString() == "cbor";
     return config;
 }
 
@@ -76,7 +84,11 @@ ConfigManager::LogConfig ConfigManager::getLogConfig() const {
             "INFO",
             "jupiter_client.log",
             1048576,
-            3
+            3,
+            false,       // Zapis synchroniczny
+            8192,        // Pojemność kolejki trybu async
+            "drop",      // Polityka przepełnienia
+            50           // Interwał zapisu na dysk (ms)
         };
     }
 
@@ -85,5 +97,30 @@ ConfigManager::LogConfig ConfigManager::getLogConfig() const {
     config.file = settings->value("LogSettings/file", "jupiter_client.log").toString();
     config.maxFileSize = settings->value("LogSettings/maxFileSize", 1048576).toLongLong();
     config.maxBackupCount = settings->value("LogSettings/maxBackupCount", 3).toInt();
+    config.async = settings->value("LogSettings/async", false).toBool();
+    config.queueCapacity = settings->value("LogSettings/queueCapacity", 8192).toInt();
+    config.overflowPolicy = settings->value("LogSettings/overflowPolicy", "drop").toString();
+    config.flushIntervalMs = settings->value("LogSettings/flushInterval", 50).toInt();
+    return config;
+}
+
+ConfigManager::ChatConfig ConfigManager::getChatConfig() const {
+    if (!configValid) {
+        qWarning() << "Configuration is invalid, returning default values";
+        return ChatConfig{
+            500,         // Wiadomości w pamięci na okno
+            524288,      // Bajty treści w pamięci na okno
+            true,        // Historia z dysku przy otwarciu okna
+            2,           // Okna czatu w puli
+            200          // Wiadomości w jednej stronie historii
+        };
+    }
+
+    ChatConfig config;
+    config.maxMessagesPerWindow = settings->value("ChatSettings/maxMessages", 500).toInt();
+    config.maxBytesPerWindow = settings->value("ChatSettings/maxBytes", 524288).toLongLong();
+    config.localHistory = settings->value("ChatSettings/localHistory", true).toBool();
+    config.windowPoolSize = settings->value("ChatSettings/windowPool", 2).toInt();
+    config.historyPageCeiling = settings->value("ChatSettings/maxHistoryPage", 200).toInt();
     return config;
 }
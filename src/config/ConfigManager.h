@@ -26,6 +26,10 @@ public:
         int reconnectDelay;
         int pingInterval;
         int connectionTimeout;
+        bool useNetworkThread;
+        qint64 writeHighWatermark;
+        qint64 writeLowWatermark;
+        bool preferCbor;
     };
 
     struct LogConfig {
@@ -33,10 +37,23 @@ public:
         QString file;
         qint64 maxFileSize;
         int maxBackupCount;
+        bool async;
+        int queueCapacity;
+        QString overflowPolicy;
+        int flushIntervalMs;
+    };
+
+    struct ChatConfig {
+        int maxMessagesPerWindow;   // 0 - bez limitu
+        qint64 maxBytesPerWindow;   // 0 - bez limitu
+        bool localHistory;          // Lokalny magazyn historii rozmów
+        int windowPoolSize;         // Ukryte okna czatu gotowe do ponownego użycia
+        int historyPageCeiling;     // Najwięcej wiadomości w jednej stronie historii, 0 - bez limitu
     };
 
     ConnectionConfig getConnectionConfig() const;
     LogConfig getLogConfig() const;
+    ChatConfig getChatConfig() const;
     bool isConfigValid() const;
 
 private:
@@ -8,12 +8,19 @@
 #include "network/NetworkManager.h"
 #include "utils/Logger.h"
 #include <QApplication>
+#include <QFile>
 
 int main(int argc, char *argv[])
 {
     // Najpierw tworzymy QApplication
     QApplication a(argc, argv);
 
+    // Jeden arkusz stylów dla całej aplikacji, parsowany raz
+    QFile styleFile(":/resources/styles.qss");
+    if (styleFile.open(QIODevice::ReadOnly)) {
+        a.setStyleSheet(QString::fromUtf8(styleFile.readAll()));
+    }
+
     // Następnie inicjalizujemy logger
     Logger::getInstance().setLogFile("jupiter_client.log");
     Logger::getInstance().setLogLevel(LogLevel::DEBUG);
@@ -0,0 +1,155 @@
+/**
+ * @file FrameDecoder.cpp
+ * @brief Incremental stream frame decoder implementation
+ * @author piotrek-pl
+ * @date 2025-02-03 18:42:17
+ */
+
+#include "FrameDecoder.h"
+#include <QtEndian>
+
+FrameDecoder::FrameDecoder(qsizetype compactThreshold)
+    : mode(Mode::JsonStream)
+    , corrupted(false)
+    , skipSeparators(false)
+    , compactThreshold(compactThreshold)
+    , readPos(0)
+    , scanPos(0)
+{
+    resetFrameState();
+}
+
+void FrameDecoder::resetFrameState()
+{
+    frameStart = -1;
+    depth = 0;
+    inString = false;
+    escaped = false;
+}
+
+void FrameDecoder::clear()
+{
+    buffer.clear();
+    readPos = 0;
+    scanPos = 0;
+    corrupted = false;
+    skipSeparators = false;
+    resetFrameState();
+}
+
+void FrameDecoder::setMode(Mode newMode)
+{
+    // Ramka JSON kończy się na '}', jej '\n' zostaje w buforze albo dopiero nadejdzie
+    skipSeparators = (mode == Mode::JsonStream && newMode == Mode::LengthPrefixed);
+    mode = newMode;
+    scanPos = readPos;
+    resetFrameState();
+}
+
+void FrameDecoder::append(const QByteArray& data)
+{
+    if (data.isEmpty()) return;
+
+    compact();
+    buffer.append(data);
+}
+
+void FrameDecoder::compact()
+{
+    if (readPos == 0) return;
+
+    // Wszystko skonsumowane - bufor można wyczyścić bez kopiowania
+    if (readPos == buffer.size()) {
+        buffer.resize(0);
+        scanPos = 0;
+        readPos = 0;
+        return;
+    }
+
+    // Kompaktujemy tylko gdy skonsumowany prefiks jest duży
+    if (readPos < compactThreshold || readPos * 2 < buffer.size()) return;
+
+    buffer.remove(0, readPos);
+    scanPos -= readPos;
+    if (frameStart >= 0) frameStart -= readPos;
+    readPos = 0;
+}
+
+bool FrameDecoder::nextFrame(QByteArray& frame)
+{
+    if (corrupted) return false;
+
+    return mode == Mode::LengthPrefixed ? nextLengthPrefixedFrame(frame)
+                                        : nextJsonFrame(frame);
+}
+
+bool FrameDecoder::nextLengthPrefixedFrame(QByteArray& frame)
+{
+    // Pierwszy bajt prefiksu to 0 dla ramek do MAX_FRAME_SIZE - nie pomylimy go z separatorem
+    if (skipSeparators) {
+        while (readPos < buffer.size() && (buffer.at(readPos) == '\n' || buffer.at(readPos) == '\r')) {
+            ++readPos;
+        }
+        scanPos = readPos;
+        if (readPos == buffer.size()) return false;
+        skipSeparators = false;
+    }
+
+    if (bufferedBytes() < LENGTH_PREFIX_SIZE) return false;
+
+    const quint32 length = qFromBigEndian<quint32>(buffer.constData() + readPos);
+    if (length > MAX_FRAME_SIZE) {
+        corrupted = true;
+        return false;
+    }
+
+    if (bufferedBytes() < LENGTH_PREFIX_SIZE + qsizetype(length)) return false;
+
+    frame = buffer.mid(readPos + LENGTH_PREFIX_SIZE, length);
+    readPos += LENGTH_PREFIX_SIZE + length;
+    scanPos = readPos;
+    return true;
+}
+
+bool FrameDecoder::nextJsonFrame(QByteArray& frame)
+{
+    const char* data = buffer.constData();
+    const qsizetype size = buffer.size();
+
+    for (qsizetype i = scanPos; i < size; ++i) {
+        const char c = data[i];
+
+        if (frameStart < 0) {
+            // Pomijamy separatory i śmieci pomiędzy ramkami
+            if (c == '{') {
+                frameStart = i;
+                depth = 1;
+            } else {
+                readPos = i + 1;
+            }
+            continue;
+        }
+
+        if (inString) {
+            if (escaped) escaped = false;
+            else if (c == '\\') escaped = true;
+            else if (c == '"') inString = false;
+            continue;
+        }
+
+        if (c == '"') {
+            inString = true;
+        } else if (c == '{') {
+            ++depth;
+        } else if (c == '}' && --depth == 0) {
+            frame = buffer.mid(frameStart, i - frameStart + 1);
+            readPos = i + 1;
+            scanPos = i + 1;
+            resetFrameState();
+            return true;
+        }
+    }
+
+    scanPos = size;
+    return false;
+}
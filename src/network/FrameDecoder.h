@@ -0,0 +1,65 @@
+/**
+ * @file FrameDecoder.h
+ * @brief Incremental stream frame decoder definition
+ * @author piotrek-pl
+ * @date 2025-02-03 18:42:17
+ */
+
+#pragma once
+
+#include <QByteArray>
+
+/**
+ * Splits a TCP byte stream into frames.
+ *
+ * In JsonStream mode frames are top-level JSON objects. The decoder keeps its
+ * scan position and string/escape state between append() calls, so every
+ * byte is inspected exactly once no matter how the stream is fragmented.
+ * In LengthPrefixed mode every frame is preceded by a 4-byte big-endian length.
+ * After a switch from JsonStream, '\r'/'\n' separators still in front of the
+ * first length prefix are skipped, also when they arrive in a later append().
+ * Consumed frames only advance a read offset; the underlying buffer is
+ * compacted once the consumed prefix grows large.
+ */
+class FrameDecoder {
+public:
+    enum class Mode {
+        JsonStream,
+        LengthPrefixed
+    };
+
+    static constexpr qsizetype DEFAULT_COMPACT_THRESHOLD = 64 * 1024;
+    static constexpr quint32 MAX_FRAME_SIZE = 16 * 1024 * 1024;
+    static constexpr int LENGTH_PREFIX_SIZE = 4;
+
+    explicit FrameDecoder(qsizetype compactThreshold = DEFAULT_COMPACT_THRESHOLD);
+
+    void append(const QByteArray& data);
+    bool nextFrame(QByteArray& frame);
+    void clear();
+
+    // Zmiana trybu obowiązuje od pierwszego nieskonsumowanego bajtu (po separatorach JSON)
+    void setMode(Mode newMode);
+    Mode currentMode() const { return mode; }
+
+    bool isCorrupted() const { return corrupted; }
+    qsizetype bufferedBytes() const { return buffer.size() - readPos; }
+
+private:
+    void compact();
+    void resetFrameState();
+    bool nextJsonFrame(QByteArray& frame);
+    bool nextLengthPrefixedFrame(QByteArray& frame);
+
+    QByteArray buffer;
+    Mode mode;
+    bool corrupted;
+    bool skipSeparators;   // Separator ostatniej ramki JSON może jeszcze nie być skonsumowany
+    qsizetype compactThreshold;
+    qsizetype readPos;     // Początek nieskonsumowanych danych
+    qsizetype scanPos;     // Następny bajt do przeskanowania
+    qsizetype frameStart;  // Początek bieżącej ramki lub -1
+    int depth;
+    bool inString;
+    bool escaped;
+};
@@ -0,0 +1,127 @@
+/**
+ * @file MessageRouter.cpp
+ * @brief Routes decoded server messages to subscribers by message type
+ * @author piotrek-pl
+ * @date 2025-02-05 17:36:48
+ */
+
+#include "MessageRouter.h"
+#include "utils/Logger.h"
+
+MessageRouter::MessageRouter(QObject* parent)
+    : QObject(parent)
+    , delivered(0)
+    , dropped(0)
+{
+}
+
+void MessageRouter::subscribe(QObject* subscriber, Protocol::MessageType::Id type, Handler handler)
+{
+    if (!subscriber || type == Protocol::MessageType::Id::UNKNOWN) return;
+
+    trackSubscriber(subscriber);
+    routes[static_cast<int>(type)].append(Subscription{subscriber, std::move(handler)});
+}
+
+void MessageRouter::subscribePeer(QObject* subscriber, Protocol::MessageType::Id type,
+                                  int peerId, Handler handler)
+{
+    if (!subscriber || type == Protocol::MessageType::Id::UNKNOWN || peerId == NO_PEER) return;
+
+    trackSubscriber(subscriber);
+    peerRoutes[static_cast<int>(type)][peerId].append(Subscription{subscriber, std::move(handler)});
+}
+
+void MessageRouter::trackSubscriber(QObject* subscriber)
+{
+    if (trackedSubscribers.contains(subscriber)) return;
+
+    trackedSubscribers.insert(subscriber);
+    connect(subscriber, &QObject::destroyed, this, [this, subscriber]() {
+        unsubscribe(subscriber);
+    });
+}
+
+void MessageRouter::unsubscribe(QObject* subscriber)
+{
+    auto matches = [subscriber](const Subscription& subscription) {
+        return subscription.subscriber == subscriber || subscription.subscriber.isNull();
+    };
+
+    for (Route& route : routes) {
+        route.removeIf(matches);
+    }
+    for (QHash<int, Route>& byPeer : peerRoutes) {
+        for (auto it = byPeer.begin(); it != byPeer.end();) {
+            it->removeIf(matches);
+            it = it->isEmpty() ? byPeer.erase(it) : std::next(it);
+        }
+    }
+
+    if (trackedSubscribers.remove(subscriber)) {
+        disconnect(subscriber, &QObject::destroyed, this, nullptr);
+    }
+}
+
+int MessageRouter::peerIdOf(const QJsonObject& message)
+{
+    auto it = message.constFind(QLatin1String("friend_id"));
+    if (it == message.constEnd()) {
+        it = message.constFind(QLatin1String("from"));
+    }
+    return it == message.constEnd() ? NO_PEER : it->toInt(NO_PEER);
+}
+
+int MessageRouter::deliver(const Route& route, const QJsonObject& message)
+{
+    // Kopia (współdzielona) chroni przed zmianą subskrypcji w trakcie obsługi
+    const Route subscriptions = route;
+    int count = 0;
+    for (const Subscription& subscription : subscriptions) {
+        if (subscription.subscriber) {
+            subscription.handler(message);
+            ++count;
+        }
+    }
+    return count;
+}
+
+void MessageRouter::dispatch(Protocol::MessageType::Id type, const QJsonObject& message)
+{
+    if (type == Protocol::MessageType::Id::UNKNOWN) {
+        ++dropped;
+        return;
+    }
+
+    const int index = static_cast<int>(type);
+    int count = deliver(routes[index], message);
+
+    const QHash<int, Route>& byPeer = peerRoutes[index];
+    if (!byPeer.isEmpty()) {
+        const int peerId = peerIdOf(message);
+        if (peerId != NO_PEER) {
+            auto it = byPeer.constFind(peerId);
+            if (it != byPeer.constEnd()) {
+                count += deliver(*it, message);
+            }
+        } else {
+            // Brak identyfikatora rozmówcy - dostarczamy wszystkim subskrybentom tego typu
+            const QList<Route> peerLists = byPeer.values();
+            for (const Route& route : peerLists) {
+                count += deliver(route, message);
+            }
+        }
+    }
+
+    if (count == 0) {
+        ++dropped;
+        LOG_DEBUG(QString("MessageRouter: no subscriber for %1").arg(Protocol::MessageType::toString(type)));
+    }
+    delivered += count;
+}
+
+void MessageRouter::resetCounters()
+{
+    delivered = 0;
+    dropped = 0;
+}
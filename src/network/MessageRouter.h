@@ -0,0 +1,60 @@
+/**
+ * @file MessageRouter.h
+ * @brief Routes decoded server messages to subscribers by message type
+ * @author piotrek-pl
+ * @date 2025-02-05 17:36:48
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QJsonObject>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+#include <array>
+#include <functional>
+#include "Protocol.h"
+
+class MessageRouter : public QObject {
+    Q_OBJECT
+
+public:
+    using Handler = std::function<void(const QJsonObject&)>;
+
+    explicit MessageRouter(QObject* parent = nullptr);
+
+    static constexpr int NO_PEER = -1;
+
+    // Subskrypcja jest usuwana automatycznie po zniszczeniu subskrybenta
+    void subscribe(QObject* subscriber, Protocol::MessageType::Id type, Handler handler);
+    // Ruch czatu: tylko wiadomości z danym "friend_id"/"from"
+    void subscribePeer(QObject* subscriber, Protocol::MessageType::Id type, int peerId, Handler handler);
+    void unsubscribe(QObject* subscriber);
+
+    void dispatch(Protocol::MessageType::Id type, const QJsonObject& message);
+
+    static int peerIdOf(const QJsonObject& message);
+
+    quint64 deliveredCount() const { return delivered; }
+    quint64 droppedCount() const { return dropped; }
+    void resetCounters();
+
+private:
+    struct Subscription {
+        QPointer<QObject> subscriber;
+        Handler handler;
+    };
+    using Route = QVector<Subscription>;
+
+    void trackSubscriber(QObject* subscriber);
+    int deliver(const Route& route, const QJsonObject& message);
+
+    std::array<Route, Protocol::MessageType::COUNT> routes;
+    std::array<QHash<int, Route>, Protocol::MessageType::COUNT> peerRoutes;
+    QSet<QObject*> trackedSubscribers;
+
+    quint64 delivered;  // Wywołania handlerów
+    quint64 dropped;    // Ramki bez żadnego odbiorcy
+};
@@ -6,26 +6,47 @@
  */
 
 #include "NetworkManager.h"
-#include <QApplication>
+#include "WireCodec.h"
+#include <QCoreApplication>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QMutexLocker>
 
 NetworkManager& NetworkManager::getInstance() {
     static NetworkManager* instance = nullptr;
-    if (!instance && QApplication::instance()) {
+    if (!instance && QCoreApplication::instance()) {
         instance = new NetworkManager();
-        instance->moveToThread(QApplication::instance()->thread());
+        if (instance->connectionConfig.useNetworkThread) {
+            instance->startNetworkThread();
+        } else {
+            instance->moveToThread(QCoreApplication::instance()->thread());
+            // Wiadomości wysłane tuż przed quit() (np. logout) nie czekają na flush z pętli zdarzeń
+            connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+                    &instance->uiContext, []() {
+                        instance->flushOutbound();
+                        instance->socket.flush();
+                    });
+        }
     }
     return *instance;
 }
 
 NetworkManager::NetworkManager()
     : QObject(nullptr)
+    , socket(this)
+    , readReceiptAggregator([this](const QJsonObject& message) { sendMessage(message); })
+    , nextRequestId(1)
+    , networkThread(nullptr)
     , connectionCheckTimer(nullptr)
+    , wireFormat(Protocol::WireFormat::Json)
+    , outboundFlushScheduled(false)
+    , pendingWriteBytes(0)
+    , m_writeBackpressured(false)
     , lastPongTime(QDateTime::currentMSecsSinceEpoch())
     , missedPings(0)
     , reconnectAttempts(0)
     , isReconnecting(false)
+    , m_isConnected(false)
     , m_isAuthenticated(false)
     , state(Protocol::SessionState::INITIAL)
 {
@@ -47,10 +68,60 @@ NetworkManager::~NetworkManager() {
     LOG_INFO("NetworkManager destroyed");
 }
 
+void NetworkManager::startNetworkThread() {
+    // Socket, dekoder ramek i timery są dziećmi this - przenoszą się razem z nim
+    networkThread = new QThread();
+    networkThread->setObjectName("NetworkThread");
+    moveToThread(networkThread);
+
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+            &uiContext, [this]() { stopNetworkThread(); });
+
+    networkThread->start();
+    LOG_INFO("Network I/O moved to dedicated worker thread");
+}
+
+void NetworkManager::stopNetworkThread() {
+    if (!networkThread) return;
+
+    // Zdarzenia wysłane wcześniej (np. logout) są obsługiwane przed zatrzymaniem wątku.
+    // Potem NetworkManager wraca do wątku GUI, więc późniejsze wywołania (np. logout
+    // z ~MainWindow) wykonują się od razu zamiast trafiać do zatrzymanego wątku.
+    QThread* guiThread = QCoreApplication::instance()->thread();
+    QMetaObject::invokeMethod(this, [this, guiThread]() {
+        flushOutbound();
+        socket.flush();
+        moveToThread(guiThread);
+    }, Qt::BlockingQueuedConnection);
+    networkThread->quit();
+    networkThread->wait();
+    delete networkThread;
+    networkThread = nullptr;
+    LOG_INFO("Network worker thread stopped, network I/O back on the GUI thread");
+}
+
+bool NetworkManager::deferToNetworkThread(std::function<void()> task) {
+    if (QThread::currentThread() == thread()) {
+        return false;
+    }
+
+    QMetaObject::invokeMethod(this, std::move(task), Qt::QueuedConnection);
+    return true;
+}
+
+QString NetworkManager::getUsername() const {
+    QMutexLocker locker(&sessionMutex);
+    return currentUsername;
+}
+
 void NetworkManager::initializeNetworking() {
+    connect(&socket, &QAbstractSocket::stateChanged, this, [this](QAbstractSocket::SocketState socketState) {
+        m_isConnected = (socketState == QAbstractSocket::ConnectedState);
+    });
     connect(&socket, &QTcpSocket::connected, this, &NetworkManager::onConnected);
     connect(&socket, &QTcpSocket::disconnected, this, &NetworkManager::onDisconnected);
     connect(&socket, &QTcpSocket::readyRead, this, &NetworkManager::onReadyRead);
+    connect(&socket, &QTcpSocket::bytesWritten, this, &NetworkManager::updateWriteBackpressure);
     connect(&socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
             this, &NetworkManager::onError);
 
@@ -63,6 +134,8 @@ void NetworkManager::initializeNetworking() {
 }
 
 void NetworkManager::connectToServer() {
+    if (deferToNetworkThread([this]() { connectToServer(); })) return;
+
     if (socket.state() == QAbstractSocket::UnconnectedState && !isReconnecting) {
         LOG_INFO(QString("Connecting to %1:%2").arg(connectionConfig.host).arg(connectionConfig.port));
         emitConnectionStatus(QString("Connecting to %1:%2...").arg(connectionConfig.host).arg(connectionConfig.port));
@@ -70,47 +143,167 @@ void NetworkManager::connectToServer() {
     }
 }
 
+void NetworkManager::connectToServer(const QString& host, quint16 port) {
+    if (deferToNetworkThread([this, host, port]() { connectToServer(host, port); })) return;
+
+    connectionConfig.host = host;
+    connectionConfig.port = port;
+    if (socket.state() != QAbstractSocket::UnconnectedState) {
+        socket.abort();
+    }
+    isReconnecting = false;
+    connectToServer();
+}
+
 void NetworkManager::disconnectFromServer() {
+    if (deferToNetworkThread([this]() { disconnectFromServer(); })) return;
+
     if (socket.state() == QAbstractSocket::ConnectedState) {
         LOG_INFO("Disconnecting from server");
         socket.disconnectFromHost();
     }
 }
 
-void NetworkManager::sendMessage(const QJsonObject& message) {
+quint64 NetworkManager::sendRequest(QJsonObject request, Protocol::MessageType::Id responseType,
+                                    QObject* context, PendingRequests::ResponseCallback onResponse,
+                                    PendingRequests::FailureCallback onFailure, int timeoutMs) {
+    const quint64 requestId = nextRequestId++;
+    request["req_id"] = static_cast<qint64>(requestId);
+    pendingRequests.add(request, responseType, context, std::move(onResponse), std::move(onFailure), timeoutMs);
+    sendMessage(request);
+    return requestId;
+}
+
+void NetworkManager::sendMessage(const QJsonObject& message, FlushMode mode) {
+    if (deferToNetworkThread([this, message, mode]() { sendMessage(message, mode); })) return;
+
     if (socket.state() != QAbstractSocket::ConnectedState) {
         LOG_WARNING("Attempting to send message while not connected");
         emitConnectionStatus("Not connected to server");
         return;
     }
 
-    QByteArray data = QJsonDocument(message).toJson(QJsonDocument::Compact);
-    data.append('\n');
-    LOG_INFO("Sending message: " + QString::fromUtf8(data));
-    socket.write(data);
-    socket.flush();
+    QJsonObject stamped = message;
+    if (!stamped.contains(QLatin1String("req_id"))) {
+        stamped["req_id"] = static_cast<qint64>(nextRequestId++);
+    }
+
+    QByteArray data = WireCodec::encode(stamped, wireFormat);
+    if (wireFormat == Protocol::WireFormat::Json) {
+        LOG_DEBUG("Sending message: " + QString::fromUtf8(data));
+    } else {
+        LOG_DEBUG(QString("Sending message: %1 (%2 bytes CBOR)")
+                     .arg(stamped["type"].toString())
+                     .arg(data.size()));
+    }
+
+    outboundBuffer.append(data);
+    {
+        QMutexLocker locker(&statsMutex);
+        currentWriteStats.messagesQueued++;
+        currentWriteStats.bytesQueued += data.size();
+    }
+
+    // Po wyjściu z a.exec() zakolejkowany flush już się nie wykona
+    if (mode == FlushMode::FlushNow || QThread::currentThread()->loopLevel() == 0) {
+        flushOutbound();
+        socket.flush();
+        return;
+    }
+    scheduleOutboundFlush();
+    updateWriteBackpressure();
+}
+
+void NetworkManager::scheduleOutboundFlush() {
+    if (outboundFlushScheduled) return;
+
+    // Wszystkie wiadomości z bieżącej iteracji pętli zdarzeń trafiają do jednego write()
+    outboundFlushScheduled = true;
+    QMetaObject::invokeMethod(this, [this]() { flushOutbound(); }, Qt::QueuedConnection);
+}
+
+void NetworkManager::flushOutbound() {
+    outboundFlushScheduled = false;
+    if (outboundBuffer.isEmpty()) return;
+
+    if (socket.state() != QAbstractSocket::ConnectedState) {
+        LOG_WARNING(QString("Dropping %1 queued bytes - not connected").arg(outboundBuffer.size()));
+        resetOutbound();
+        return;
+    }
+
+    socket.write(outboundBuffer);
+    outboundBuffer.clear();
+    {
+        QMutexLocker locker(&statsMutex);
+        currentWriteStats.socketWrites++;
+    }
+    updateWriteBackpressure();
+}
+
+void NetworkManager::updateWriteBackpressure() {
+    pendingWriteBytes = socket.bytesToWrite() + outboundBuffer.size();
+
+    if (!m_writeBackpressured && pendingWriteBytes >= connectionConfig.writeHighWatermark) {
+        m_writeBackpressured = true;
+        LOG_WARNING(QString("Write backpressure on: %1 bytes pending").arg(pendingWriteBytes.load()));
+        emit writeBackpressureChanged(true);
+    } else if (m_writeBackpressured && pendingWriteBytes <= connectionConfig.writeLowWatermark) {
+        m_writeBackpressured = false;
+        LOG_INFO(QString("Write backpressure off: %1 bytes pending").arg(pendingWriteBytes.load()));
+        emit writeBackpressureChanged(false);
+    }
+}
+
+void NetworkManager::resetOutbound() {
+    outboundBuffer.clear();
+    updateWriteBackpressure();
+}
+
+NetworkManager::WriteStats NetworkManager::writeStats() const {
+    QMutexLocker locker(&statsMutex);
+    return currentWriteStats;
 }
 
 void NetworkManager::login(const QString& username, const QString& password) {
-    currentUsername = username;
+    if (deferToNetworkThread([this, username, password]() { login(username, password); })) return;
+
+    {
+        QMutexLocker locker(&sessionMutex);
+        currentUsername = username;
+    }
     currentPassword = password;
 
-    QJsonObject loginRequest = Protocol::MessageStructure::createLoginRequest(username, password);
+    QStringList capabilities{Protocol::Capabilities::STATUS_DELTA, Protocol::Capabilities::READ_BATCH};
+    if (connectionConfig.preferCbor) {
+        capabilities << Protocol::Capabilities::CBOR;
+    }
+
+    QJsonObject loginRequest = Protocol::MessageStructure::createLoginRequest(username, password, capabilities);
     sendMessage(loginRequest);
     emitConnectionStatus("Logging in...");
 }
 
 void NetworkManager::registerUser(const QString& username, const QString& password, const QString& email) {
+    if (deferToNetworkThread([this, username, password, email]() {
+            registerUser(username, password, email);
+        })) return;
+
     QJsonObject registerRequest = Protocol::MessageStructure::createRegisterRequest(username, password, email);
     sendMessage(registerRequest);
     emitConnectionStatus("Registering...");
 }
 
 void NetworkManager::logout() {
+    if (deferToNetworkThread([this]() { logout(); })) return;
+
     if (m_isAuthenticated) {
         QJsonObject logoutRequest = Protocol::MessageStructure::createLogoutRequest();
-        sendMessage(logoutRequest);
-        currentUsername.clear();
+        sendMessage(logoutRequest, FlushMode::FlushNow);
+        {
+            QMutexLocker locker(&sessionMutex);
+            currentUsername.clear();
+        }
         currentPassword.clear();
         m_isAuthenticated = false;
     }
@@ -163,6 +356,12 @@ void NetworkManager::scheduleReconnection() {
 }
 
 void NetworkManager::onConnected() {
+    frameDecoder.clear();
+    setWireFormat(Protocol::WireFormat::Json);
+    {
+        QMutexLocker locker(&statsMutex);
+        currentWriteStats = WriteStats();
+    }
     lastPongTime = QDateTime::currentMSecsSinceEpoch();
     missedPings = 0;
     reconnectAttempts = 0;
@@ -179,6 +378,17 @@ void NetworkManager::onConnected() {
 
 void NetworkManager::onDisconnected() {
     LOG_WARNING("Disconnected from server");
+    WriteStats stats = writeStats();
+    LOG_INFO(QString("Write coalescing: %1 messages in %2 writes (%3 syscalls saved)")
+                 .arg(stats.messagesQueued)
+                 .arg(stats.socketWrites)
+                 .arg(stats.syscallsSaved()));
+    resetOutbound();
+    // Odpowiedzi na wysłane żądania już nie nadejdą
+    QMetaObject::invokeMethod(&pendingRequests, [this]() {
+        pendingRequests.failAll();
+        readReceiptAggregator.clear();
+    }, Qt::QueuedConnection);
     emitConnectionStatus("Disconnected from server");
     m_isAuthenticated = false;
     emit disconnected();
@@ -221,59 +431,65 @@ void NetworkManager::onError(QTcpSocket::SocketError socketError) {
 void NetworkManager::onReadyRead() {
     if (!socket.bytesAvailable()) return;
 
-    buffer.append(socket.readAll());
+    frameDecoder.append(socket.readAll());
     processBuffer();
 }
 
 void NetworkManager::processBuffer() {
-    bool foundJson;
-    do {
-        foundJson = false;
-        int startPos = buffer.indexOf('{');
-        if (startPos >= 0) {
-            int endPos;
-            QJsonObject jsonObject;
-
-            if (parseJsonFromBuffer(startPos, endPos, jsonObject)) {
-                processIncomingMessage(jsonObject);
-                buffer.remove(0, endPos + 1);
-                foundJson = true;
-            }
+    QList<IncomingMessage> messages;
+    QByteArray frame;
+    while (frameDecoder.nextFrame(frame)) {
+        if (wireFormat == Protocol::WireFormat::Json) {
+            LOG_DEBUG("Processing JSON: " + QString::fromUtf8(frame));
         }
-    } while (foundJson);
-}
-
-bool NetworkManager::parseJsonFromBuffer(int startPos, int& endPos, QJsonObject& jsonObject) {
-    endPos = -1;
-    int braceCount = 1;
 
-    for (int i = startPos + 1; i < buffer.size(); ++i) {
-        if (buffer[i] == '{') braceCount++;
-        else if (buffer[i] == '}') {
-            braceCount--;
-            if (braceCount == 0) {
-                endPos = i;
-                break;
+        QJsonObject json;
+        QString errorString;
+        if (WireCodec::decode(frame, wireFormat, json, errorString)) {
+            const auto type = Protocol::MessageType::fromString(json["type"].toString());
+            if (processIncomingMessage(type, json)) {
+                messages.append(IncomingMessage{type, json, frame.size()});
             }
+        } else {
+            LOG_ERROR(QString("Frame decode error: %1").arg(errorString));
         }
     }
 
-    if (endPos > startPos) {
-        QByteArray jsonData = buffer.mid(startPos, endPos - startPos + 1);
-        LOG_INFO("Processing JSON: " + QString::fromUtf8(jsonData));
+    deliverMessages(messages);
+
+    if (frameDecoder.isCorrupted()) {
+        LOG_ERROR("Invalid frame length received - dropping connection");
+        socket.abort();
+    }
+}
+
+void NetworkManager::setWireFormat(Protocol::WireFormat format) {
+    if (wireFormat == format) return;
+
+    // Ramki już zbuforowane za bieżącą są dekodowane w nowym formacie
+    wireFormat = format;
+    frameDecoder.setMode(WireCodec::decoderModeFor(format));
+    LOG_INFO(QString("Wire format switched to %1")
+                 .arg(format == Protocol::WireFormat::Cbor ? "CBOR" : "JSON"));
+}
 
-        QJsonParseError error;
-        QJsonDocument doc = QJsonDocument::fromJson(jsonData, &error);
+void NetworkManager::deliverMessages(const QList<IncomingMessage>& messages) {
+    if (messages.isEmpty()) return;
 
-        if (error.error == QJsonParseError::NoError) {
-            jsonObject = doc.object();
-            return true;
-        } else {
-            LOG_ERROR(QString("JSON parse error: %1").arg(error.errorString()));
+    auto emitBatch = [this, messages]() {
+        for (const IncomingMessage& message : messages) {
+            pendingRequests.complete(message.type, message.json, message.wireBytes);
+            messageRouter.dispatch(message.type, message.json);
+            emit messageReceived(message.json);
         }
-    }
+    };
 
-    return false;
+    // Cała paczka z jednego odczytu trafia do wątku GUI jednym zdarzeniem
+    if (QThread::currentThread() == uiContext.thread()) {
+        emitBatch();
+    } else {
+        QMetaObject::invokeMethod(&uiContext, emitBatch, Qt::QueuedConnection);
+    }
 }
 
 void NetworkManager::handleLoginResponse(const QJsonObject& json) {
@@ -283,6 +499,14 @@ void NetworkManager::handleLoginResponse(const QJsonObject& json) {
         lastPongTime = QDateTime::currentMSecsSinceEpoch();
         missedPings = 0;
 
+        // Serwer bez obsługi CBOR nie ogłasza tej możliwości - zostajemy przy JSON
+        QJsonArray serverCapabilities = json["capabilities"].toArray();
+        if (connectionConfig.preferCbor &&
+            serverCapabilities.contains(QJsonValue(Protocol::Capabilities::CBOR))) {
+            setWireFormat(Protocol::WireFormat::Cbor);
+        }
+        readReceiptAggregator.setBatched(serverCapabilities.contains(QJsonValue(Protocol::Capabilities::READ_BATCH)));
+
         QJsonObject statusUpdate = Protocol::MessageStructure::createStatusUpdate(Protocol::UserStatus::ONLINE);
         sendMessage(statusUpdate);
 
@@ -294,7 +518,10 @@ void NetworkManager::handleLoginResponse(const QJsonObject& json) {
     } else {
         LOG_WARNING(QString("Login failed: %1").arg(json["message"].toString()));
         emitConnectionStatus("Login failed: " + json["message"].toString());
-        currentUsername.clear();
+        {
+            QMutexLocker locker(&sessionMutex);
+            currentUsername.clear();
+        }
         currentPassword.clear();
         m_isAuthenticated = false;
         emit error(json["message"].toString());
@@ -338,49 +565,44 @@ void NetworkManager::handlePingMessage(const QJsonObject& json) {
     missedPings = 0;
 }
 
-void NetworkManager::processIncomingMessage(const QJsonObject& json) {
-    QString type = json["type"].toString();
-    LOG_DEBUG(QString("Processing message type: %1").arg(type));
+bool NetworkManager::processIncomingMessage(Protocol::MessageType::Id type, const QJsonObject& json) {
+    using Protocol::MessageType::Id;
+    LOG_DEBUG(QString("Processing message type: %1").arg(Protocol::MessageType::toString(type)));
 
-    if (type == Protocol::MessageType::ERROR &&
+    if (type == Id::ERROR &&
         !m_isAuthenticated &&
         json["message"].toString() == "Not authenticated") {
         LOG_DEBUG("Ignoring 'Not authenticated' error - not logged in yet");
         lastPongTime = QDateTime::currentMSecsSinceEpoch();
-        return;
+        return false;
     }
 
-    if (type == Protocol::MessageType::PING) {
+    switch (type) {
+    case Id::PING:
         handlePingMessage(json);
-        return;
-    }
-
-    if (type == Protocol::MessageType::LOGIN_RESPONSE) {
+        return false;
+    case Id::LOGIN_RESPONSE:
         handleLoginResponse(json);
-    }
-    else if (type == Protocol::MessageType::REGISTER_RESPONSE) {
+        break;
+    case Id::REGISTER_RESPONSE:
         handleRegisterResponse(json);
-    }
-    else if (type == Protocol::MessageType::ERROR) {
+        break;
+    case Id::ERROR:
         handleErrorMessage(json);
-    }
-    // Znane typy wiadomości, które są obsługiwane przez odpowiednie dialogi
-    else if (type == Protocol::MessageType::UNREAD_FROM ||
-             type == Protocol::MessageType::FRIENDS_LIST_RESPONSE ||
-             type == Protocol::MessageType::FRIENDS_STATUS_UPDATE ||
-             type == Protocol::MessageType::RECEIVED_INVITATIONS_RESPONSE ||
-             type == Protocol::MessageType::SENT_INVITATIONS_RESPONSE) {
-        LOG_DEBUG(QString("Message type %1 will be handled by appropriate dialog").arg(type));
-    }
-    else if (type != Protocol::MessageType::ERROR) {
-        LOG_WARNING(QString("Received unknown message type: %1").arg(type));
+        break;
+    case Id::UNKNOWN:
+        LOG_WARNING(QString("Received unknown message type: %1").arg(json["type"].toString()));
+        break;
+    default:
+        // Pozostałe typy obsługują subskrybenci MessageRouter
+        break;
     }
 
-    emit messageReceived(json);
-
-    if (type != Protocol::MessageType::ERROR || m_isAuthenticated) {
+    if (type != Id::ERROR || m_isAuthenticated) {
         lastPongTime = QDateTime::currentMSecsSinceEpoch();
     }
+
+    return true;
 }
 
 void NetworkManager::sendPong(qint64 timestamp) {
@@ -13,9 +13,17 @@
 #include <QDateTime>
 #include <QJsonObject>
 #include <QByteArray>
+#include <QThread>
+#include <QMutex>
+#include <atomic>
+#include <functional>
 #include "config/ConfigManager.h"
 #include "utils/Logger.h"
 #include "Protocol.h"
+#include "FrameDecoder.h"
+#include "MessageRouter.h"
+#include "PendingRequests.h"
+#include "ReadReceiptAggregator.h"
 
 class NetworkManager : public QObject {
     Q_OBJECT
@@ -23,18 +31,58 @@ class NetworkManager : public QObject {
 public:
     static NetworkManager& getInstance();
 
+    // Statystyki łączenia zapisów dla bieżącego połączenia
+    struct WriteStats {
+        quint64 messagesQueued = 0;
+        quint64 bytesQueued = 0;
+        quint64 socketWrites = 0;
+
+        quint64 syscallsSaved() const {
+            return messagesQueued > socketWrites ? messagesQueued - socketWrites : 0;
+        }
+    };
+
     // Connection management
     void connectToServer();
+    // Serwer inny niż w konfiguracji (np. lokalny w testach); przerywa bieżące połączenie
+    void connectToServer(const QString& host, quint16 port);
     void disconnectFromServer();
-    void sendMessage(const QJsonObject& message);
-    bool isConnected() const { return socket.state() == QAbstractSocket::ConnectedState; }
+    enum class FlushMode {
+        Coalesce,   // Zapis przy następnym przebiegu pętli zdarzeń, razem z innymi wiadomościami
+        FlushNow    // Zapis do gniazda od razu (logout, zamykanie aplikacji)
+    };
+
+    // Każda wysyłana wiadomość dostaje "req_id", jeśli go jeszcze nie ma.
+    // Bez działającej pętli zdarzeń wiadomość jest zapisywana od razu.
+    void sendMessage(const QJsonObject& message, FlushMode mode = FlushMode::Coalesce);
+    // Żądanie z oczekiwaniem na odpowiedź: onResponse dostaje odpowiedź na to
+    // konkretne żądanie, onFailure - timeout, błąd serwera lub rozłączenie.
+    // Wywoływać z wątku GUI; callbacki też trafiają do wątku GUI.
+    quint64 sendRequest(QJsonObject request, Protocol::MessageType::Id responseType, QObject* context,
+                        PendingRequests::ResponseCallback onResponse,
+                        PendingRequests::FailureCallback onFailure = nullptr,
+                        int timeoutMs = Protocol::Timeouts::REQUEST);
+    bool isConnected() const { return m_isConnected; }
     bool isAuthenticated() const { return m_isAuthenticated; }
+    bool isThreaded() const { return networkThread != nullptr; }
+
+    // Backpressure zapisu
+    qint64 bytesToWrite() const { return pendingWriteBytes; }
+    bool isWriteBackpressured() const { return m_writeBackpressured; }
+    WriteStats writeStats() const;
 
     // Authentication
     void login(const QString& username, const QString& password);
     void registerUser(const QString& username, const QString& password, const QString& email);
     void logout();
-    QString getUsername() const { return currentUsername; }
+    QString getUsername() const;
+
+    // Rejestr subskrybentów wiadomości (żyje w wątku GUI)
+    MessageRouter& router() { return messageRouter; }
+    // Oczekujące żądania i opóźnienia odpowiedzi (wątek GUI)
+    PendingRequests& requests() { return pendingRequests; }
+    // Potwierdzenia odczytu łączone per rozmowa (wątek GUI)
+    ReadReceiptAggregator& readReceipts() { return readReceiptAggregator; }
 
 signals:
     void connected();
@@ -44,6 +92,7 @@ signals:
     void registrationSuccessful();
     void error(const QString& error);
     void connectionStatusChanged(const QString& status);
+    void writeBackpressureChanged(bool backpressured);
 
 private:
     NetworkManager();
@@ -51,8 +100,17 @@ private:
     NetworkManager(const NetworkManager&) = delete;
     NetworkManager& operator=(const NetworkManager&) = delete;
 
+    struct IncomingMessage {
+        Protocol::MessageType::Id type;
+        QJsonObject json;
+        qint64 wireBytes;   // Rozmiar ramki
+    };
+
     // Initialization
     void initializeNetworking();
+    void startNetworkThread();
+    void stopNetworkThread();
+    bool deferToNetworkThread(std::function<void()> task);
 
     // Connection management
     void checkConnection();
@@ -62,20 +120,41 @@ private:
 
     // Message processing
     void processBuffer();
-    void processIncomingMessage(const QJsonObject& json);
-    bool parseJsonFromBuffer(int startPos, int& endPos, QJsonObject& jsonObject);
+    bool processIncomingMessage(Protocol::MessageType::Id type, const QJsonObject& json);
+    void deliverMessages(const QList<IncomingMessage>& messages);
+    void setWireFormat(Protocol::WireFormat format);
     void handleLoginResponse(const QJsonObject& json);
     void handleRegisterResponse(const QJsonObject& json);
     void handleErrorMessage(const QJsonObject& json);
     void handlePingMessage(const QJsonObject& json);
     void sendPong(qint64 timestamp);
 
+    // Outbound queue
+    void scheduleOutboundFlush();
+    void flushOutbound();
+    void updateWriteBackpressure();
+    void resetOutbound();
+
     // Socket handling
     void handleSocketError(QAbstractSocket::SocketError socketError);
 
     QTcpSocket socket;
+    QObject uiContext;      // Pozostaje w wątku GUI - kontekst dla sygnałów do UI
+    MessageRouter messageRouter;
+    PendingRequests pendingRequests;
+    ReadReceiptAggregator readReceiptAggregator;
+    std::atomic<quint64> nextRequestId;
+    QThread* networkThread;
+    mutable QMutex sessionMutex;
+    mutable QMutex statsMutex;
     QTimer* connectionCheckTimer;
-    QByteArray buffer;
+    FrameDecoder frameDecoder;
+    Protocol::WireFormat wireFormat;
+    QByteArray outboundBuffer;
+    bool outboundFlushScheduled;
+    WriteStats currentWriteStats;
+    std::atomic<qint64> pendingWriteBytes;
+    std::atomic<bool> m_writeBackpressured;
     qint64 lastPongTime;
     int missedPings;
     int reconnectAttempts;
@@ -83,7 +162,8 @@ private:
     QString currentPassword;
     QString state;
     bool isReconnecting;
-    bool m_isAuthenticated;
+    std::atomic<bool> m_isConnected;
+    std::atomic<bool> m_isAuthenticated;
     ConfigManager::ConnectionConfig connectionConfig;
     static const int MAX_RECONNECT_ATTEMPTS = 5;
     static const int RECONNECT_DELAY = 5000; // ms
@@ -0,0 +1,238 @@
+/**
+ * @file PendingRequests.cpp
+ * @brief Table of requests awaiting a response, with timeouts and latency stats
+ * @author piotrek-pl
+ * @date 2025-02-10 09:21:37
+ */
+
+#include "PendingRequests.h"
+#include "MessageRouter.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+PendingRequests::PendingRequests(int tickMs, QObject* parent)
+    : QObject(parent)
+    , tickMs(qMax(1, tickMs))
+    , timer(this)
+    , cursor(0)
+    , timedOut(0)
+{
+    timer.setInterval(this->tickMs);
+    connect(&timer, &QTimer::timeout, this, &PendingRequests::onTick);
+    clock.start();
+}
+
+quint64 PendingRequests::requestIdOf(const QJsonObject& message)
+{
+    auto it = message.constFind(QLatin1String("req_id"));
+    return it == message.constEnd() ? 0 : static_cast<quint64>(it->toInteger());
+}
+
+void PendingRequests::add(const QJsonObject& request, Protocol::MessageType::Id responseType,
+                          QObject* context, ResponseCallback onResponse, FailureCallback onFailure,
+                          int timeoutMs)
+{
+    const quint64 requestId = requestIdOf(request);
+    if (requestId == 0) return;
+
+    const int ticks = qMax(1, (timeoutMs + tickMs - 1) / tickMs);
+    wheel[(cursor + ticks) % WHEEL_SLOTS].push_back(requestId);
+
+    pending[requestId] = Pending{
+        Protocol::MessageType::fromString(request["type"].toString()),
+        responseType,
+        MessageRouter::peerIdOf(request),
+        context != nullptr,
+        context,
+        std::move(onResponse),
+        std::move(onFailure),
+        clock.elapsed(),
+        (ticks - 1) / WHEEL_SLOTS
+    };
+
+    if (!timer.isActive()) {
+        timer.start();
+    }
+}
+
+PendingRequests::PendingMap::iterator PendingRequests::findFor(Protocol::MessageType::Id type,
+                                                               const QJsonObject& response)
+{
+    const quint64 requestId = requestIdOf(response);
+    if (requestId != 0) {
+        return pending.find(requestId);
+    }
+
+    // Serwer bez "req_id" - najstarsze żądanie tego typu od tego rozmówcy
+    const int peerId = MessageRouter::peerIdOf(response);
+    return std::find_if(pending.begin(), pending.end(), [type, peerId](const auto& entry) {
+        const Pending& request = entry.second;
+        return request.responseType == type
+               && (peerId == MessageRouter::NO_PEER || request.peerId == peerId);
+    });
+}
+
+bool PendingRequests::complete(Protocol::MessageType::Id type, const QJsonObject& response, qint64 wireBytes)
+{
+    auto it = findFor(type, response);
+    if (it == pending.end()) return false;
+
+    const bool failed = (type == Protocol::MessageType::Id::ERROR);
+    if (!failed && it->second.responseType != type) return false;
+
+    Pending request = std::move(it->second);
+    pending.erase(it);
+
+    if (failed) {
+        fail(request);
+        return true;
+    }
+
+    recordLatency(request.requestType, clock.elapsed() - request.sentAt, wireBytes);
+    if (request.onResponse && (!request.hasContext || request.context)) {
+        request.onResponse(response);
+    }
+    return true;
+}
+
+void PendingRequests::cancel(QObject* context)
+{
+    for (auto it = pending.begin(); it != pending.end();) {
+        it = (it->second.hasContext && it->second.context == context) ? pending.erase(it) : std::next(it);
+    }
+}
+
+void PendingRequests::failAll()
+{
+    PendingMap failed;
+    failed.swap(pending);
+    for (auto& entry : failed) {
+        fail(entry.second);
+    }
+}
+
+void PendingRequests::fail(Pending& request)
+{
+    if (request.onFailure && (!request.hasContext || request.context)) {
+        request.onFailure();
+    }
+}
+
+void PendingRequests::onTick()
+{
+    cursor = (cursor + 1) % WHEEL_SLOTS;
+
+    // Slot może dostać nowe wpisy z callbacków - przetwarzamy kopię
+    std::vector<quint64> slot;
+    slot.swap(wheel[cursor]);
+
+    std::vector<Pending> expired;
+    for (quint64 requestId : slot) {
+        auto it = pending.find(requestId);
+        if (it == pending.end()) continue;     // Już zakończone
+
+        if (it->second.rounds > 0) {
+            --it->second.rounds;
+            wheel[cursor].push_back(requestId);
+            continue;
+        }
+
+        LOG_WARNING(QString("Request %1 (%2) timed out")
+                        .arg(requestId)
+                        .arg(Protocol::MessageType::toString(it->second.requestType)));
+        expired.push_back(std::move(it->second));
+        pending.erase(it);
+    }
+
+    timedOut += expired.size();
+    for (Pending& request : expired) {
+        fail(request);
+    }
+
+    if (pending.empty()) {
+        timer.stop();
+        for (std::vector<quint64>& ids : wheel) {
+            ids.clear();
+        }
+    }
+}
+
+void PendingRequests::recordLatency(Protocol::MessageType::Id requestType, qint64 latencyMs, qint64 wireBytes)
+{
+    if (requestType == Protocol::MessageType::Id::UNKNOWN) return;
+
+    LatencySamples& stats = latencies[static_cast<int>(requestType)];
+    if (stats.samples.size() < LATENCY_SAMPLES) {
+        stats.samples.push_back(latencyMs);
+        stats.bytes.push_back(wireBytes);
+    } else {
+        stats.samples[stats.next] = latencyMs;
+        stats.bytes[stats.next] = wireBytes;
+    }
+    stats.next = (stats.next + 1) % LATENCY_SAMPLES;
+}
+
+PendingRequests::LatencyStats PendingRequests::latency(Protocol::MessageType::Id requestType) const
+{
+    LatencyStats result;
+    if (requestType == Protocol::MessageType::Id::UNKNOWN) return result;
+
+    std::vector<qint64> sorted = latencies[static_cast<int>(requestType)].samples;
+    if (sorted.empty()) return result;
+    std::sort(sorted.begin(), sorted.end());
+
+    auto percentile = [&sorted](double p) {
+        const size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+        return sorted[qMax<size_t>(rank, 1) - 1];
+    };
+    result.samples = static_cast<int>(sorted.size());
+    result.p50 = percentile(0.50);
+    result.p90 = percentile(0.90);
+    result.p99 = percentile(0.99);
+    return result;
+}
+
+PendingRequests::TransferStats PendingRequests::transfer(Protocol::MessageType::Id requestType) const
+{
+    if (requestType == Protocol::MessageType::Id::UNKNOWN) return TransferStats();
+
+    const LatencySamples& stats = latencies[static_cast<int>(requestType)];
+    return fitTransfer(stats.samples, stats.bytes);
+}
+
+PendingRequests::TransferStats PendingRequests::fitTransfer(const std::vector<qint64>& latencies,
+                                                            const std::vector<qint64>& bytes)
+{
+    TransferStats result;
+    const size_t count = qMin(latencies.size(), bytes.size());
+    result.samples = static_cast<int>(count);
+    if (count == 0) return result;
+
+    double meanBytes = 0.0;
+    double meanLatency = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        meanBytes += bytes[i];
+        meanLatency += latencies[i];
+    }
+    meanBytes /= count;
+    meanLatency /= count;
+
+    double sxx = 0.0;
+    double sxy = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        sxx += (bytes[i] - meanBytes) * (bytes[i] - meanBytes);
+        sxy += (bytes[i] - meanBytes) * (latencies[i] - meanLatency);
+    }
+
+    // Bez rozrzutu rozmiarów (lub przy szumie większym niż koszt przesyłu) przepustowość jest nieznana
+    const double msPerByte = sxx > 0.0 ? sxy / sxx : 0.0;
+    if (count < MIN_TRANSFER_SAMPLES || msPerByte <= 0.0) {
+        result.roundTripMs = qRound64(meanLatency);
+        return result;
+    }
+
+    result.roundTripMs = qMax<qint64>(0, qRound64(meanLatency - msPerByte * meanBytes));
+    result.bytesPerMs = 1.0 / msPerByte;
+    return result;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file PendingRequests.h
+ * @brief Table of requests awaiting a response, with timeouts and latency stats
+ * @author piotrek-pl
+ * @date 2025-02-10 09:21:37
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QJsonObject>
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <array>
+#include <functional>
+#include <map>
+#include <vector>
+#include "Protocol.h"
+
+/**
+ * Requests sent with a client-generated "req_id", completed by the response
+ * carrying the same id. Responses from servers that do not echo the id are
+ * matched to the oldest request expecting that response type for the same
+ * peer. Deadlines live on a single timer wheel, so any number of pending
+ * requests costs one timer that runs only while something is pending.
+ * Lives in the GUI thread, next to MessageRouter.
+ */
+class PendingRequests : public QObject {
+    Q_OBJECT
+
+public:
+    using ResponseCallback = std::function<void(const QJsonObject& response)>;
+    // Brak odpowiedzi w terminie, błąd serwera lub zerwane połączenie
+    using FailureCallback = std::function<void()>;
+
+    struct LatencyStats {
+        int samples = 0;
+        qint64 p50 = 0;
+        qint64 p90 = 0;
+        qint64 p99 = 0;
+    };
+
+    // Opóźnienie rozłożone na stały koszt i przesył: latency = roundTrip + bytes / bytesPerMs
+    struct TransferStats {
+        int samples = 0;
+        qint64 roundTripMs = 0;
+        double bytesPerMs = 0.0;    // 0 - brak oszacowania (odpowiedzi podobnej wielkości)
+    };
+
+    static constexpr int DEFAULT_TICK_MS = 250;
+    static constexpr int WHEEL_SLOTS = 128;       // 32 s na jeden obrót przy domyślnym takcie
+    static constexpr int LATENCY_SAMPLES = 256;   // Ostatnie pomiary na typ żądania
+    static constexpr int MIN_TRANSFER_SAMPLES = 4;
+
+    explicit PendingRequests(int tickMs = DEFAULT_TICK_MS, QObject* parent = nullptr);
+
+    // request musi już zawierać "req_id"
+    void add(const QJsonObject& request, Protocol::MessageType::Id responseType, QObject* context,
+             ResponseCallback onResponse, FailureCallback onFailure, int timeoutMs);
+    // false - odpowiedź nie dotyczy żadnego oczekującego żądania.
+    // wireBytes - rozmiar ramki odpowiedzi, do oszacowania przepustowości
+    bool complete(Protocol::MessageType::Id type, const QJsonObject& response, qint64 wireBytes = 0);
+    // Porzucenie żądań kontekstu bez wywoływania callbacków
+    void cancel(QObject* context);
+    void cancelRequest(quint64 requestId) { pending.erase(requestId); }
+    // Połączenie zerwane - odpowiedzi nie nadejdą
+    void failAll();
+
+    int pendingCount() const { return static_cast<int>(pending.size()); }
+    quint64 timedOutCount() const { return timedOut; }
+    LatencyStats latency(Protocol::MessageType::Id requestType) const;
+    TransferStats transfer(Protocol::MessageType::Id requestType) const;
+
+    static quint64 requestIdOf(const QJsonObject& message);
+    // Regresja liniowa opóźnienia względem rozmiaru odpowiedzi
+    static TransferStats fitTransfer(const std::vector<qint64>& latencies, const std::vector<qint64>& bytes);
+
+private:
+    struct Pending {
+        Protocol::MessageType::Id requestType;
+        Protocol::MessageType::Id responseType;
+        int peerId;
+        bool hasContext;
+        QPointer<QObject> context;
+        ResponseCallback onResponse;
+        FailureCallback onFailure;
+        qint64 sentAt;
+        int rounds;     // Pełne obroty koła pozostałe do terminu
+    };
+
+    struct LatencySamples {
+        std::vector<qint64> samples;
+        std::vector<qint64> bytes;      // Rozmiar odpowiedzi dla tego samego pomiaru
+        size_t next = 0;
+    };
+
+    using PendingMap = std::map<quint64, Pending>;  // Identyfikatory rosną - od najstarszego
+
+    PendingMap::iterator findFor(Protocol::MessageType::Id type, const QJsonObject& response);
+    void onTick();
+    void fail(Pending& request);
+    void recordLatency(Protocol::MessageType::Id requestType, qint64 latencyMs, qint64 wireBytes);
+
+    int tickMs;
+    QTimer timer;
+    QElapsedTimer clock;
+    PendingMap pending;
+    std::array<std::vector<quint64>, WHEEL_SLOTS> wheel;
+    int cursor;
+    std::array<LatencySamples, Protocol::MessageType::COUNT> latencies;
+    quint64 timedOut;
+};
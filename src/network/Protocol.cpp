@@ -6,18 +6,98 @@
  */
 
 #include "Protocol.h"
+#include <type_traits>
 
 namespace Protocol {
+namespace MessageType {
+
+namespace {
+
+constexpr quint32 SLOT_COUNT = 512;
+constexpr quint32 NO_SEED = 0xFFFFFFFFu;
+
+// FNV-1a z ziarnem; ten sam wynik dla nazw ASCII w char i char16_t
+template <typename Char>
+constexpr quint32 hashChars(const Char* data, std::size_t size, quint32 seed)
+{
+    quint32 hash = 2166136261u ^ seed;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<quint32>(static_cast<std::make_unsigned_t<Char>>(data[i]));
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+constexpr quint32 slotFor(std::string_view name, quint32 seed)
+{
+    return hashChars(name.data(), name.size(), seed) % SLOT_COUNT;
+}
+
+constexpr bool isPerfectSeed(quint32 seed)
+{
+    bool used[SLOT_COUNT] = {};
+    for (const Entry& entry : TABLE) {
+        const quint32 slot = slotFor(entry.name, seed);
+        if (used[slot]) return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr quint32 findPerfectSeed()
+{
+    for (quint32 seed = 0; seed < 1024; ++seed) {
+        if (isPerfectSeed(seed)) return seed;
+    }
+    return NO_SEED;
+}
+
+constexpr quint32 SEED = findPerfectSeed();
+static_assert(SEED != NO_SEED, "No perfect hash seed for MessageType::TABLE - increase SLOT_COUNT");
+
+struct SlotTable {
+    quint8 entries[SLOT_COUNT];  // 0 = pusty slot, w przeciwnym razie indeks w TABLE + 1
+};
+
+constexpr SlotTable buildSlotTable()
+{
+    SlotTable table{};
+    for (int i = 0; i < COUNT; ++i) {
+        table.entries[slotFor(TABLE[i].name, SEED)] = static_cast<quint8>(i + 1);
+    }
+    return table;
+}
+
+constexpr SlotTable SLOTS = buildSlotTable();
+
+} // namespace
+
+Id fromString(QStringView type)
+{
+    const quint32 slot = hashChars(type.utf16(), static_cast<std::size_t>(type.size()), SEED) % SLOT_COUNT;
+    const int index = SLOTS.entries[slot] - 1;
+    if (index < 0) return Id::UNKNOWN;
+
+    return type == toString(TABLE[index].id) ? TABLE[index].id : Id::UNKNOWN;
+}
+
+} // namespace MessageType
+
 namespace MessageStructure {
 
 // Basic operations
-QJsonObject createLoginRequest(const QString& username, const QString& password) {
-    return QJsonObject{
+QJsonObject createLoginRequest(const QString& username, const QString& password,
+                               const QStringList& capabilities) {
+    QJsonObject request{
         {"type", MessageType::LOGIN},
         {"username", username},
         {"password", password},
         {"protocol_version", PROTOCOL_VERSION}
     };
+    if (!capabilities.isEmpty()) {
+        request["capabilities"] = QJsonArray::fromStringList(capabilities);
+    }
+    return request;
 }
 
 QJsonObject createNewMessage(const QString& content, int from, qint64 timestamp) {
@@ -29,14 +109,45 @@ QJsonObject createNewMessage(const QString& content, int from, qint64 timestamp)
     return message;
 }
 
-QJsonObject createMessageRead(int friendId) {
+QJsonObject createMessageRead(int friendId, qint64 readUntil, qint64 lastReadId) {
     QJsonObject message;
     message["type"] = Protocol::MessageType::MESSAGE_READ;
     message["friendId"] = friendId;
     message["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+    if (readUntil > 0) {
+        message["read_until"] = readUntil;
+    }
+    if (lastReadId > 0) {
+        message["last_read_id"] = lastReadId;
+    }
     return message;
 }
 
+QJsonObject createMessageReadBatch(const QJsonArray& reads) {
+    return QJsonObject{
+        {"type", MessageType::MESSAGE_READ},
+        {"reads", reads},
+        {"timestamp", QDateTime::currentMSecsSinceEpoch()}
+    };
+}
+
+QJsonObject createGetMoreHistory(int friendId, int offset, int limit,
+                                 qint64 beforeTimestamp, qint64 beforeId) {
+    QJsonObject request{
+        {"type", MessageType::GET_MORE_HISTORY},
+        {"friend_id", friendId},
+        {"offset", offset},
+        {"limit", limit}
+    };
+    if (beforeTimestamp > 0) {
+        request["before_timestamp"] = beforeTimestamp;
+    }
+    if (beforeId > 0) {
+        request["before_id"] = beforeId;
+    }
+    return request;
+}
+
 QJsonObject createRegisterRequest(const QString& username, const QString& password, const QString& email) {
     return QJsonObject{
         {"type", MessageType::REGISTER},
@@ -119,6 +230,18 @@ QJsonObject createFriendsStatusUpdate(const QJsonArray& friends) {
     };
 }
 
+QJsonObject createFriendsStatusDelta(const QJsonArray& changes,
+                                     const QJsonArray& added,
+                                     const QJsonArray& removed) {
+    return QJsonObject{
+        {"type", MessageType::FRIENDS_STATUS_DELTA},
+        {"changes", changes},
+        {"added", added},
+        {"removed", removed},
+        {"timestamp", QDateTime::currentMSecsSinceEpoch()}
+    };
+}
+
 QJsonObject createMessageReadResponse() {
     return QJsonObject{
         {"type", MessageType::MESSAGE_READ_RESPONSE},
@@ -128,20 +251,36 @@ QJsonObject createMessageReadResponse() {
 }
 
 // Search operations
-QJsonObject createSearchUsersRequest(const QString& query) {
-    return QJsonObject{
+QJsonObject createSearchUsersRequest(const QString& query, qint64 searchId) {
+    QJsonObject request{
         {"type", MessageType::SEARCH_USERS},
         {"query", query},
         {"timestamp", QDateTime::currentMSecsSinceEpoch()}
     };
+    if (searchId > 0) {
+        request["search_id"] = searchId;
+    }
+    return request;
 }
 
-QJsonObject createSearchUsersResponse(const QJsonArray& users) {
-    return QJsonObject{
+QJsonObject createSearchUsersResponse(const QJsonArray& users, qint64 searchId) {
+    QJsonObject response{
         {"type", MessageType::SEARCH_USERS_RESPONSE},
         {"users", users},
         {"timestamp", QDateTime::currentMSecsSinceEpoch()}
     };
+    if (searchId > 0) {
+        response["search_id"] = searchId;
+    }
+    return response;
+}
+
+QJsonObject createSearchUsersCancel(qint64 searchId) {
+    return QJsonObject{
+        {"type", MessageType::SEARCH_USERS_CANCEL},
+        {"search_id", searchId},
+        {"timestamp", QDateTime::currentMSecsSinceEpoch()}
+    };
 }
 
 // Friend management operations
@@ -230,34 +369,50 @@ QJsonObject createFriendRequestRejectResponse(bool success, const QString& messa
     };
 }
 
-QJsonObject createGetSentInvitationsRequest() {
-    return QJsonObject{
+QJsonObject createGetSentInvitationsRequest(qint64 knownVersion) {
+    QJsonObject request{
         {"type", MessageType::GET_SENT_INVITATIONS},
         {"timestamp", QDateTime::currentMSecsSinceEpoch()}
     };
+    if (knownVersion >= 0) {
+        request["known_version"] = knownVersion;
+    }
+    return request;
 }
 
-QJsonObject createGetReceivedInvitationsRequest() {
-    return QJsonObject{
+QJsonObject createGetReceivedInvitationsRequest(qint64 knownVersion) {
+    QJsonObject request{
         {"type", MessageType::GET_RECEIVED_INVITATIONS},
         {"timestamp", QDateTime::currentMSecsSinceEpoch()}
     };
+    if (knownVersion >= 0) {
+        request["known_version"] = knownVersion;
+    }
+    return request;
 }
 
-QJsonObject createSentInvitationsResponse(const QJsonArray& invitations) {
-    return QJsonObject{
+QJsonObject createSentInvitationsResponse(const QJsonArray& invitations, qint64 version) {
+    QJsonObject response{
         {"type", MessageType::SENT_INVITATIONS_RESPONSE},
         {"invitations", invitations},
         {"timestamp", QDateTime::currentMSecsSinceEpoch()}
     };
+    if (version >= 0) {
+        response["version"] = version;
+    }
+    return response;
 }
 
-QJsonObject createReceivedInvitationsResponse(const QJsonArray& invitations) {
-    return QJsonObject{
+QJsonObject createReceivedInvitationsResponse(const QJsonArray& invitations, qint64 version) {
+    QJsonObject response{
         {"type", MessageType::RECEIVED_INVITATIONS_RESPONSE},
         {"invitations", invitations},
         {"timestamp", QDateTime::currentMSecsSinceEpoch()}
     };
+    if (version >= 0) {
+        response["version"] = version;
+    }
+    return response;
 }
 
 QJsonObject createCancelFriendRequest(int requestId) {
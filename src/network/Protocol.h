@@ -13,12 +13,29 @@
 #include <QJsonArray>
 #include <QDateTime>
 #include <QStringList>
+#include <QStringView>
+#include <QLatin1String>
+#include <string_view>
 
 namespace Protocol {
 
 // Wersja protokołu
 constexpr int PROTOCOL_VERSION = 1;
 
+// Kodowanie ramek na łączu. Format obowiązuje całe połączenie: po uzgodnieniu
+// przy logowaniu setWireFormat przełącza koder i dekoder ramek.
+enum class WireFormat {
+    Json,   // Kompaktowy JSON zakończony znakiem nowej linii
+    Cbor    // CBOR poprzedzony 4-bajtową długością (big-endian)
+};
+
+// Możliwości negocjowane przy logowaniu
+namespace Capabilities {
+const QString CBOR = "cbor";
+const QString STATUS_DELTA = "status_delta";
+const QString READ_BATCH = "read_batch";    // Potwierdzenia odczytu wielu rozmów w jednej ramce
+}
+
 // Timeouty (w milisekundach)
 namespace Timeouts {
 constexpr int CONNECTION = 30000; // 30 sekund
@@ -41,6 +58,7 @@ const QString STATUS_UPDATE = "status_response";
 const QString GET_FRIENDS_LIST = "get_friends_list";
 const QString FRIENDS_LIST_RESPONSE = "friends_list_response";
 const QString FRIENDS_STATUS_UPDATE = "friends_status_update";
+const QString FRIENDS_STATUS_DELTA = "friends_status_delta";
 const QString SEND_MESSAGE = "send_message";
 const QString MESSAGE_RESPONSE = "message_response";
 const QString MESSAGE_ACK = "message_ack";
@@ -61,6 +79,7 @@ const QString UNREAD_FROM = "unread_from";
 const QString MESSAGE_READ_RESPONSE = "message_read_response";
 const QString SEARCH_USERS = "search_users";
 const QString SEARCH_USERS_RESPONSE = "search_users_response";
+const QString SEARCH_USERS_CANCEL = "search_users_cancel";
 const QString REMOVE_FRIEND = "remove_friend";
 const QString REMOVE_FRIEND_RESPONSE = "remove_friend_response";
 const QString FRIEND_REMOVED = "friend_removed";
@@ -92,6 +111,163 @@ const QString GET_INVITATIONS = "get_invitations";
 const QString INVITATIONS_LIST = "invitations_list";
 const QString INVITATION_ALREADY_EXISTS = "invitation_already_exists";
 const QString INVITATION_STATUS_CHANGED = "invitation_status_changed";
+
+// Identyfikatory typów - typ wiadomości jest dekodowany raz na ramkę
+enum class Id : quint8 {
+    LOGIN,
+    LOGIN_RESPONSE,
+    REGISTER,
+    REGISTER_RESPONSE,
+    LOGOUT,
+    LOGOUT_RESPONSE,
+    GET_STATUS,
+    STATUS_UPDATE,
+    GET_FRIENDS_LIST,
+    FRIENDS_LIST_RESPONSE,
+    FRIENDS_STATUS_UPDATE,
+    FRIENDS_STATUS_DELTA,
+    SEND_MESSAGE,
+    MESSAGE_RESPONSE,
+    MESSAGE_ACK,
+    GET_MESSAGES,
+    PENDING_MESSAGES,
+    ERROR,
+    PING,
+    PONG,
+    GET_CHAT_HISTORY,
+    CHAT_HISTORY_RESPONSE,
+    GET_MORE_HISTORY,
+    MORE_HISTORY_RESPONSE,
+    GET_LATEST_MESSAGES,
+    LATEST_MESSAGES_RESPONSE,
+    NEW_MESSAGES,
+    MESSAGE_READ,
+    UNREAD_FROM,
+    MESSAGE_READ_RESPONSE,
+    SEARCH_USERS,
+    SEARCH_USERS_RESPONSE,
+    SEARCH_USERS_CANCEL,
+    REMOVE_FRIEND,
+    REMOVE_FRIEND_RESPONSE,
+    FRIEND_REMOVED,
+    FRIEND_REQUEST_ACCEPTED_NOTIFICATION,
+    ADD_FRIEND_REQUEST,
+    ADD_FRIEND_RESPONSE,
+    FRIEND_REQUEST_RECEIVED,
+    FRIEND_REQUEST_ACCEPT,
+    FRIEND_REQUEST_REJECT,
+    FRIEND_REQUEST_ACCEPT_RESPONSE,
+    FRIEND_REQUEST_REJECT_RESPONSE,
+    GET_SENT_INVITATIONS,
+    GET_RECEIVED_INVITATIONS,
+    SENT_INVITATIONS_RESPONSE,
+    RECEIVED_INVITATIONS_RESPONSE,
+    CANCEL_FRIEND_REQUEST,
+    CANCEL_FRIEND_REQUEST_RESPONSE,
+    FRIEND_REQUEST_CANCELLED_NOTIFICATION,
+    SEND_INVITATION,
+    INVITATION_RESPONSE,
+    INVITATION_ACCEPTED,
+    INVITATION_REJECTED,
+    INVITATION_CANCELLED,
+    GET_INVITATIONS,
+    INVITATIONS_LIST,
+    INVITATION_ALREADY_EXISTS,
+    INVITATION_STATUS_CHANGED,
+    UNKNOWN
+};
+
+constexpr int COUNT = static_cast<int>(Id::UNKNOWN);
+
+struct Entry {
+    Id id;
+    std::string_view name;
+};
+
+// Tablica id <-> nazwa, kolejność zgodna z Id
+inline constexpr Entry TABLE[] = {
+    {Id::LOGIN, "login"},
+    {Id::LOGIN_RESPONSE, "login_response"},
+    {Id::REGISTER, "register"},
+    {Id::REGISTER_RESPONSE, "register_response"},
+    {Id::LOGOUT, "logout"},
+    {Id::LOGOUT_RESPONSE, "logout_response"},
+    {Id::GET_STATUS, "get_status"},
+    {Id::STATUS_UPDATE, "status_response"},
+    {Id::GET_FRIENDS_LIST, "get_friends_list"},
+    {Id::FRIENDS_LIST_RESPONSE, "friends_list_response"},
+    {Id::FRIENDS_STATUS_UPDATE, "friends_status_update"},
+    {Id::FRIENDS_STATUS_DELTA, "friends_status_delta"},
+    {Id::SEND_MESSAGE, "send_message"},
+    {Id::MESSAGE_RESPONSE, "message_response"},
+    {Id::MESSAGE_ACK, "message_ack"},
+    {Id::GET_MESSAGES, "get_messages"},
+    {Id::PENDING_MESSAGES, "pending_messages"},
+    {Id::ERROR, "error"},
+    {Id::PING, "ping"},
+    {Id::PONG, "pong"},
+    {Id::GET_CHAT_HISTORY, "get_chat_history"},
+    {Id::CHAT_HISTORY_RESPONSE, "chat_history_response"},
+    {Id::GET_MORE_HISTORY, "get_more_history"},
+    {Id::MORE_HISTORY_RESPONSE, "more_history_response"},
+    {Id::GET_LATEST_MESSAGES, "get_latest_messages"},
+    {Id::LATEST_MESSAGES_RESPONSE, "latest_messages_response"},
+    {Id::NEW_MESSAGES, "new_messages"},
+    {Id::MESSAGE_READ, "message_read"},
+    {Id::UNREAD_FROM, "unread_from"},
+    {Id::MESSAGE_READ_RESPONSE, "message_read_response"},
+    {Id::SEARCH_USERS, "search_users"},
+    {Id::SEARCH_USERS_RESPONSE, "search_users_response"},
+    {Id::SEARCH_USERS_CANCEL, "search_users_cancel"},
+    {Id::REMOVE_FRIEND, "remove_friend"},
+    {Id::REMOVE_FRIEND_RESPONSE, "remove_friend_response"},
+    {Id::FRIEND_REMOVED, "friend_removed"},
+    {Id::FRIEND_REQUEST_ACCEPTED_NOTIFICATION, "friend_request_accepted_notification"},
+    {Id::ADD_FRIEND_REQUEST, "add_friend_request"},
+    {Id::ADD_FRIEND_RESPONSE, "add_friend_response"},
+    {Id::FRIEND_REQUEST_RECEIVED, "friend_request_received"},
+    {Id::FRIEND_REQUEST_ACCEPT, "friend_request_accept"},
+    {Id::FRIEND_REQUEST_REJECT, "friend_request_reject"},
+    {Id::FRIEND_REQUEST_ACCEPT_RESPONSE, "friend_request_accept_response"},
+    {Id::FRIEND_REQUEST_REJECT_RESPONSE, "friend_request_reject_response"},
+    {Id::GET_SENT_INVITATIONS, "get_sent_invitations"},
+    {Id::GET_RECEIVED_INVITATIONS, "get_received_invitations"},
+    {Id::SENT_INVITATIONS_RESPONSE, "sent_invitations_response"},
+    {Id::RECEIVED_INVITATIONS_RESPONSE, "received_invitations_response"},
+    {Id::CANCEL_FRIEND_REQUEST, "cancel_friend_request"},
+    {Id::CANCEL_FRIEND_REQUEST_RESPONSE, "cancel_friend_request_response"},
+    {Id::FRIEND_REQUEST_CANCELLED_NOTIFICATION, "friend_request_cancelled_notification"},
+    {Id::SEND_INVITATION, "send_invitation"},
+    {Id::INVITATION_RESPONSE, "invitation_response"},
+    {Id::INVITATION_ACCEPTED, "invitation_accepted"},
+    {Id::INVITATION_REJECTED, "invitation_rejected"},
+    {Id::INVITATION_CANCELLED, "invitation_cancelled"},
+    {Id::GET_INVITATIONS, "get_invitations"},
+    {Id::INVITATIONS_LIST, "invitations_list"},
+    {Id::INVITATION_ALREADY_EXISTS, "invitation_already_exists"},
+    {Id::INVITATION_STATUS_CHANGED, "invitation_status_changed"},
+};
+
+constexpr bool isTableOrdered()
+{
+    for (int i = 0; i < COUNT; ++i) {
+        if (static_cast<int>(TABLE[i].id) != i) return false;
+    }
+    return true;
+}
+
+static_assert(sizeof(TABLE) / sizeof(TABLE[0]) == COUNT, "MessageType::TABLE must cover every Id");
+static_assert(isTableOrdered(), "MessageType::TABLE must be ordered by Id");
+
+constexpr QLatin1String toString(Id id)
+{
+    return id == Id::UNKNOWN ? QLatin1String()
+                             : QLatin1String(TABLE[static_cast<int>(id)].name.data(),
+                                             static_cast<int>(TABLE[static_cast<int>(id)].name.size()));
+}
+
+// Wyszukiwanie przez doskonałe haszowanie - jedno porównanie napisów
+Id fromString(QStringView type);
 }
 
 // Status użytkownika
@@ -142,6 +318,7 @@ const QStringList AUTHENTICATED = {
     MessageType::REMOVE_FRIEND_RESPONSE,
     MessageType::SEARCH_USERS,
     MessageType::SEARCH_USERS_RESPONSE,
+    MessageType::SEARCH_USERS_CANCEL,
     // Friend Request System
     MessageType::ADD_FRIEND_REQUEST,
     MessageType::ADD_FRIEND_RESPONSE,
@@ -176,7 +353,8 @@ const QStringList DISCONNECTING = {
 // Struktury wiadomości
 namespace MessageStructure {
 // Podstawowe operacje
-QJsonObject createLoginRequest(const QString& username, const QString& password);
+QJsonObject createLoginRequest(const QString& username, const QString& password,
+                               const QStringList& capabilities = QStringList());
 QJsonObject createRegisterRequest(const QString& username, const QString& password, const QString& email);
 QJsonObject createLogoutRequest();
 
@@ -184,9 +362,17 @@ QJsonObject createLogoutRequest();
 QJsonObject createMessage(int receiverId, const QString& content);
 QJsonObject createMessageAck(const QString& messageId);
 QJsonObject createStatusUpdate(const QString& status);
-QJsonObject createMessageRead(int friendId);
+// readUntil - czas najnowszej przeczytanej wiadomości (ms), lastReadId - jej identyfikator, jeśli znany
+QJsonObject createMessageRead(int friendId, qint64 readUntil = 0, qint64 lastReadId = 0);
+// reads: [{friendId, read_until, last_read_id?}]
+QJsonObject createMessageReadBatch(const QJsonArray& reads);
 QJsonObject createMessageReadResponse();
 
+// Historia: strona starsza od kursora (before_timestamp w ms, before_id gdy znany).
+// offset zostaje dla serwerów bez obsługi kursora.
+QJsonObject createGetMoreHistory(int friendId, int offset, int limit,
+                                 qint64 beforeTimestamp = 0, qint64 beforeId = 0);
+
 // Ping/Pong
 QJsonObject createPing();
 QJsonObject createPong(qint64 timestamp);
@@ -197,6 +383,10 @@ QJsonObject createError(const QString& message);
 // Lista znajomych
 QJsonObject createGetFriendsList();
 QJsonObject createFriendsStatusUpdate(const QJsonArray& friends);
+// Delta: "changes" [{id, status}], "added" [{id, username, status}], "removed" [id]
+QJsonObject createFriendsStatusDelta(const QJsonArray& changes,
+                                     const QJsonArray& added = QJsonArray(),
+                                     const QJsonArray& removed = QJsonArray());
 QJsonObject createRemoveFriendRequest(int friendId);
 QJsonObject createRemoveFriendResponse(bool success);
 QJsonObject createFriendRemovedNotification(int friendId);
@@ -204,9 +394,10 @@ QJsonObject createFriendRemovedNotification(int friendId);
 // Wiadomości czatu
 QJsonObject createNewMessage(const QString& content, int from, qint64 timestamp);
 
-// Wyszukiwanie użytkowników
-QJsonObject createSearchUsersRequest(const QString& query);
-QJsonObject createSearchUsersResponse(const QJsonArray& users);
+// Wyszukiwanie użytkowników - search_id odsyłany w odpowiedzi (0 - bez identyfikatora)
+QJsonObject createSearchUsersRequest(const QString& query, qint64 searchId = 0);
+QJsonObject createSearchUsersResponse(const QJsonArray& users, qint64 searchId = 0);
+QJsonObject createSearchUsersCancel(qint64 searchId);
 
 // Friend Request System
 QJsonObject createAddFriendRequest(int userId);
@@ -216,10 +407,11 @@ QJsonObject createFriendRequestAccept(int requestId);
 QJsonObject createFriendRequestReject(int requestId);
 QJsonObject createFriendRequestAcceptResponse(bool success, const QString& message = "");
 QJsonObject createFriendRequestRejectResponse(bool success, const QString& message = "");
-QJsonObject createGetSentInvitationsRequest();
-QJsonObject createGetReceivedInvitationsRequest();
-QJsonObject createSentInvitationsResponse(const QJsonArray& invitations);
-QJsonObject createReceivedInvitationsResponse(const QJsonArray& invitations);
+// known_version / version: wersja listy po stronie serwera (-1 - brak)
+QJsonObject createGetSentInvitationsRequest(qint64 knownVersion = -1);
+QJsonObject createGetReceivedInvitationsRequest(qint64 knownVersion = -1);
+QJsonObject createSentInvitationsResponse(const QJsonArray& invitations, qint64 version = -1);
+QJsonObject createReceivedInvitationsResponse(const QJsonArray& invitations, qint64 version = -1);
 QJsonObject createCancelFriendRequest(int requestId);
 QJsonObject createCancelFriendRequestResponse(bool success, const QString& message = "");
 QJsonObject createFriendRequestAcceptedNotification(int userId, const QString& username);
@@ -234,7 +426,7 @@ QJsonObject createInvitationStatusChangedNotification(int requestId, int userId,
 
 // Historia czatu
 namespace ChatHistory {
-const int MESSAGE_BATCH_SIZE = 20;  // ilość wiadomości w jednej paczce
+const int MESSAGE_BATCH_SIZE = 20;  // minimalna paczka bez pomiarów łącza (HistoryPageSizer)
 }
 
 // Walidacja wiadomości
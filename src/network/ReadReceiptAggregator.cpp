@@ -0,0 +1,99 @@
+/**
+ * @file ReadReceiptAggregator.cpp
+ * @brief Coalescing of message_read receipts per conversation implementation
+ * @author piotrek-pl
+ * @date 2025-02-10 20:14:33
+ */
+
+#include "ReadReceiptAggregator.h"
+#include "Protocol.h"
+#include <QJsonArray>
+
+ReadReceiptAggregator::ReadReceiptAggregator(Sender sender, int intervalMs, QObject* parent)
+    : QObject(parent)
+    , sender(std::move(sender))
+    , intervalMs(qMax(0, intervalMs))
+    , batchedFrames(false)
+    , timer(this)
+    , lastFlush(-1)
+    , frames(0)
+    , suppressed(0)
+{
+    timer.setSingleShot(true);
+    connect(&timer, &QTimer::timeout, this, &ReadReceiptAggregator::flush);
+    clock.start();
+}
+
+bool ReadReceiptAggregator::advances(const Mark& mark, qint64 timestamp, qint64 messageId)
+{
+    if (messageId != 0 && mark.messageId != 0) {
+        return messageId > mark.messageId;
+    }
+    return timestamp > mark.timestamp;
+}
+
+bool ReadReceiptAggregator::markRead(int friendId, qint64 timestamp, qint64 messageId)
+{
+    auto it = pending.find(friendId);
+    const Mark current = it != pending.end() ? *it : sent.value(friendId);
+    if (!advances(current, timestamp, messageId)) {
+        ++suppressed;
+        return false;
+    }
+
+    pending[friendId] = Mark{qMax(timestamp, current.timestamp), qMax(messageId, current.messageId)};
+    schedule();
+    return true;
+}
+
+void ReadReceiptAggregator::schedule()
+{
+    if (timer.isActive()) return;
+
+    // Pierwsze potwierdzenie w następnym obiegu pętli zdarzeń - łączy zgłoszenia z jednego otwarcia okna
+    const qint64 sinceFlush = lastFlush < 0 ? intervalMs : clock.elapsed() - lastFlush;
+    timer.start(static_cast<int>(qMax<qint64>(0, intervalMs - sinceFlush)));
+}
+
+void ReadReceiptAggregator::flush()
+{
+    timer.stop();
+    if (pending.isEmpty()) return;
+
+    lastFlush = clock.elapsed();
+    if (batchedFrames && pending.size() > 1) {
+        QJsonArray reads;
+        for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+            QJsonObject read{{"friendId", it.key()}, {"read_until", it->timestamp}};
+            if (it->messageId != 0) {
+                read["last_read_id"] = it->messageId;
+            }
+            reads.append(read);
+        }
+        sender(Protocol::MessageStructure::createMessageReadBatch(reads));
+        ++frames;
+    } else {
+        for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+            sender(Protocol::MessageStructure::createMessageRead(it.key(), it->timestamp, it->messageId));
+            ++frames;
+        }
+    }
+
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        sent[it.key()] = it.value();
+    }
+    pending.clear();
+}
+
+void ReadReceiptAggregator::clear()
+{
+    timer.stop();
+    sent.clear();
+    pending.clear();
+}
+
+qint64 ReadReceiptAggregator::readMark(int friendId) const
+{
+    auto it = pending.constFind(friendId);
+    return it != pending.constEnd() ? it->timestamp : sent.value(friendId).timestamp;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file ReadReceiptAggregator.h
+ * @brief Coalescing of message_read receipts per conversation definition
+ * @author piotrek-pl
+ * @date 2025-02-10 20:14:33
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+
+/**
+ * Keeps a cumulative read mark per conversation: the newest message the
+ * user has seen (timestamp, plus id when the server sends ids). Receipts
+ * that do not move the mark forward are dropped; the rest are held and
+ * flushed at most once per interval, so one chat open sends one receipt
+ * no matter how many code paths report it. A server announcing
+ * Capabilities::READ_BATCH gets all pending conversations in one frame.
+ * Lives in the GUI thread, next to PendingRequests.
+ */
+class ReadReceiptAggregator : public QObject {
+    Q_OBJECT
+
+public:
+    using Sender = std::function<void(const QJsonObject& message)>;
+
+    static constexpr int DEFAULT_INTERVAL_MS = 1000;
+
+    explicit ReadReceiptAggregator(Sender sender, int intervalMs = DEFAULT_INTERVAL_MS,
+                                   QObject* parent = nullptr);
+
+    // Przeczytane wszystko do timestamp (ms) włącznie; false - znacznik się nie przesunął
+    bool markRead(int friendId, qint64 timestamp, qint64 messageId = 0);
+    // Serwer przyjmuje potwierdzenia wielu rozmów w jednej ramce (można wywołać z wątku sieci)
+    void setBatched(bool batched) { batchedFrames = batched; }
+
+    void flush();
+    // Nowa sesja lub zerwane połączenie - serwer mógł nie dostać wysłanych znaczników
+    void clear();
+
+    qint64 readMark(int friendId) const;
+    int pendingCount() const { return pending.size(); }
+    quint64 sentFrames() const { return frames; }
+    quint64 suppressedCount() const { return suppressed; }
+
+private:
+    struct Mark {
+        qint64 timestamp = 0;
+        qint64 messageId = 0;
+    };
+
+    static bool advances(const Mark& mark, qint64 timestamp, qint64 messageId);
+    void schedule();
+
+    Sender sender;
+    int intervalMs;
+    std::atomic<bool> batchedFrames;
+    QTimer timer;
+    QElapsedTimer clock;
+    qint64 lastFlush;
+    QHash<int, Mark> sent;
+    QHash<int, Mark> pending;
+    quint64 frames;
+    quint64 suppressed;
+};
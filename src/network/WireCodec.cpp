@@ -0,0 +1,69 @@
+/**
+ * @file WireCodec.cpp
+ * @brief Message encoding for the negotiated wire format
+ * @author piotrek-pl
+ * @date 2025-02-04 20:15:32
+ */
+
+#include "WireCodec.h"
+#include <QCborMap>
+#include <QCborStreamWriter>
+#include <QCborValue>
+#include <QJsonDocument>
+#include <QtEndian>
+
+namespace WireCodec {
+
+QByteArray encode(const QJsonObject& message, Protocol::WireFormat format)
+{
+    if (format == Protocol::WireFormat::Json) {
+        QByteArray data = QJsonDocument(message).toJson(QJsonDocument::Compact);
+        data.append('\n');
+        return data;
+    }
+
+    // Miejsce na prefiks długości, treść CBOR dopisywana bezpośrednio za nim
+    QByteArray data(FrameDecoder::LENGTH_PREFIX_SIZE, '\0');
+    {
+        QCborStreamWriter writer(&data);
+        QCborValue(QCborMap::fromJsonObject(message)).toCbor(writer);
+    }
+    qToBigEndian<quint32>(quint32(data.size() - FrameDecoder::LENGTH_PREFIX_SIZE), data.data());
+    return data;
+}
+
+bool decode(const QByteArray& frame, Protocol::WireFormat format,
+            QJsonObject& message, QString& errorString)
+{
+    if (format == Protocol::WireFormat::Json) {
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(frame, &error);
+        if (error.error != QJsonParseError::NoError) {
+            errorString = error.errorString();
+            return false;
+        }
+        message = doc.object();
+        return true;
+    }
+
+    QCborParserError error;
+    QCborValue value = QCborValue::fromCbor(frame, &error);
+    if (error.error != QCborError::NoError) {
+        errorString = error.errorString();
+        return false;
+    }
+    if (!value.isMap()) {
+        errorString = "CBOR frame is not a map";
+        return false;
+    }
+    message = value.toMap().toJsonObject();
+    return true;
+}
+
+FrameDecoder::Mode decoderModeFor(Protocol::WireFormat format)
+{
+    return format == Protocol::WireFormat::Cbor ? FrameDecoder::Mode::LengthPrefixed
+                                                : FrameDecoder::Mode::JsonStream;
+}
+
+} // namespace WireCodec
@@ -0,0 +1,27 @@
+/**
+ * @file WireCodec.h
+ * @brief Message encoding for the negotiated wire format
+ * @author piotrek-pl
+ * @date 2025-02-04 20:15:32
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include "Protocol.h"
+#include "FrameDecoder.h"
+
+namespace WireCodec {
+
+// Koduje wiadomość razem z ramkowaniem (znak nowej linii lub prefiks długości)
+QByteArray encode(const QJsonObject& message, Protocol::WireFormat format);
+
+// Dekoduje ramkę zwróconą przez FrameDecoder (bez ramkowania)
+bool decode(const QByteArray& frame, Protocol::WireFormat format,
+            QJsonObject& message, QString& errorString);
+
+FrameDecoder::Mode decoderModeFor(Protocol::WireFormat format);
+
+} // namespace WireCodec
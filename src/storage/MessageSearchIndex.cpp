@@ -0,0 +1,334 @@
+/**
+ * @file MessageSearchIndex.cpp
+ * @brief Full-text index over locally stored messages implementation
+ * @author piotrek-pl
+ * @date 2025-02-08 16:41:05
+ */
+
+#include "MessageSearchIndex.h"
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <algorithm>
+
+namespace {
+const quint32 INDEX_MAGIC = 0x4A534958;  // "JSIX"
+const quint32 INDEX_VERSION = 1;
+}
+
+QStringList MessageSearchIndex::tokenize(const QString& text)
+{
+    QStringList tokens;
+    QString current;
+    for (const QChar ch : text) {
+        if (ch.isLetterOrNumber()) {
+            current.append(ch.toLower());
+            continue;
+        }
+        if (!current.isEmpty()) {
+            tokens.append(current.left(MAX_TOKEN_LENGTH));
+            current.clear();
+        }
+    }
+    if (!current.isEmpty()) {
+        tokens.append(current.left(MAX_TOKEN_LENGTH));
+    }
+    return tokens;
+}
+
+void MessageSearchIndex::appendVarint(QByteArray& out, quint32 value)
+{
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+void MessageSearchIndex::decode(const PostingList& list, std::vector<quint32>& out)
+{
+    const uchar* data = reinterpret_cast<const uchar*>(list.deltas.constData());
+    const uchar* end = data + list.deltas.size();
+    quint32 document = 0;
+    while (data < end) {
+        quint32 delta = 0;
+        int shift = 0;
+        while (data < end) {
+            const uchar byte = *data++;
+            delta |= static_cast<quint32>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+            shift += 7;
+        }
+        document += delta;
+        out.push_back(document);
+    }
+}
+
+bool MessageSearchIndex::isValid(const PostingList& list, quint32 documentTotal)
+{
+    const uchar* data = reinterpret_cast<const uchar*>(list.deltas.constData());
+    const uchar* end = data + list.deltas.size();
+    quint64 document = 0;
+    quint32 count = 0;
+    while (data < end) {
+        quint64 delta = 0;
+        int shift = 0;
+        bool complete = false;
+        while (data < end && shift < 35) {
+            const uchar byte = *data++;
+            delta |= static_cast<quint64>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                complete = true;
+                break;
+            }
+            shift += 7;
+        }
+        // Tylko pierwszy identyfikator może być zerem
+        if (!complete || (count > 0 && delta == 0)) return false;
+
+        document += delta;
+        if (document >= documentTotal) return false;
+        ++count;
+    }
+    return count == list.count && (count == 0 || document == list.lastDocument);
+}
+
+void MessageSearchIndex::add(int friendId, qint64 sequence, const QString& text)
+{
+    QStringList tokens = tokenize(text);
+    tokens.removeDuplicates();
+
+    QWriteLocker locker(&lock);
+    const quint32 document = static_cast<quint32>(documents.size());
+    documents.push_back(Document{friendId, sequence});
+    indexed[friendId] = sequence + 1;
+
+    for (const QString& token : tokens) {
+        PostingList& list = postings[token];
+        // Identyfikatory rosną, więc pierwsza różnica to sam identyfikator
+        appendVarint(list.deltas, document - list.lastDocument);
+        list.lastDocument = document;
+        ++list.count;
+    }
+}
+
+void MessageSearchIndex::removeConversation(int friendId)
+{
+    QWriteLocker locker(&lock);
+    if (!indexed.remove(friendId)) return;
+
+    // Listy wpisów zostają do compact() - usunięte dokumenty są pomijane przy wyszukiwaniu
+    for (Document& document : documents) {
+        if (document.friendId == friendId) {
+            document.friendId = -1;
+            ++removed;
+        }
+    }
+}
+
+bool MessageSearchIndex::needsCompaction() const
+{
+    QReadLocker locker(&lock);
+    return removed >= static_cast<quint32>(COMPACT_MIN_REMOVED) && removed * 4 >= documents.size();
+}
+
+void MessageSearchIndex::compact()
+{
+    QWriteLocker locker(&lock);
+    if (removed == 0) return;
+
+    // Nowe identyfikatory zachowują kolejność, więc listy pozostają rosnące
+    constexpr quint32 REMOVED = 0xFFFFFFFF;
+    std::vector<quint32> renumbered(documents.size(), REMOVED);
+    std::vector<Document> live;
+    live.reserve(documents.size() - removed);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        if (documents[i].friendId >= 0) {
+            renumbered[i] = static_cast<quint32>(live.size());
+            live.push_back(documents[i]);
+        }
+    }
+
+    std::vector<quint32> ids;
+    for (auto it = postings.begin(); it != postings.end();) {
+        ids.clear();
+        decode(it->second, ids);
+
+        PostingList list;
+        for (const quint32 id : ids) {
+            const quint32 document = renumbered[id];
+            if (document == REMOVED) continue;
+            appendVarint(list.deltas, document - list.lastDocument);
+            list.lastDocument = document;
+            ++list.count;
+        }
+
+        if (list.count == 0) {
+            it = postings.erase(it);
+        } else {
+            it->second = std::move(list);
+            ++it;
+        }
+    }
+
+    documents.swap(live);
+    removed = 0;
+}
+
+qint64 MessageSearchIndex::indexedCount(int friendId) const
+{
+    QReadLocker locker(&lock);
+    return indexed.value(friendId, 0);
+}
+
+std::vector<quint32> MessageSearchIndex::matchPrefix(const QString& prefix) const
+{
+    std::vector<quint32> result;
+    size_t lists = 0;
+    for (auto it = postings.lower_bound(prefix); it != postings.end() && it->first.startsWith(prefix); ++it) {
+        decode(it->second, result);
+        ++lists;
+    }
+
+    // Suma kilku posortowanych list
+    if (lists > 1) {
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+    return result;
+}
+
+QList<MessageSearchIndex::Hit> MessageSearchIndex::search(const QString& query, int limit) const
+{
+    QList<Hit> hits;
+    QStringList terms = tokenize(query);
+    terms.removeDuplicates();
+    if (terms.isEmpty() || limit <= 0) return hits;
+
+    QReadLocker locker(&lock);
+
+    std::vector<quint32> matches;
+    std::vector<quint32> next;
+    std::vector<quint32> intersection;
+    for (qsizetype i = 0; i < terms.size(); ++i) {
+        if (i == 0) {
+            matches = matchPrefix(terms[i]);
+        } else {
+            next = matchPrefix(terms[i]);
+            intersection.clear();
+            std::set_intersection(matches.begin(), matches.end(), next.begin(), next.end(),
+                                  std::back_inserter(intersection));
+            matches.swap(intersection);
+        }
+        if (matches.empty()) return hits;
+    }
+
+    for (auto it = matches.rbegin(); it != matches.rend() && hits.size() < limit; ++it) {
+        const Document& document = documents[*it];
+        if (document.friendId >= 0) {
+            hits.append(Hit{document.friendId, document.sequence});
+        }
+    }
+    return hits;
+}
+
+bool MessageSearchIndex::save(const QString& path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    QReadLocker locker(&lock);
+
+    out << INDEX_MAGIC << INDEX_VERSION;
+    out << static_cast<quint32>(documents.size());
+    for (const Document& document : documents) {
+        out << document.friendId << document.sequence;
+    }
+    out << indexed;
+    out << static_cast<quint32>(postings.size());
+    for (const auto& [token, list] : postings) {
+        out << token << list.count << list.lastDocument << list.deltas;
+    }
+    locker.unlock();
+
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+bool MessageSearchIndex::load(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION) return false;
+
+    std::vector<Document> loadedDocuments;
+    QHash<int, qint64> loadedIndexed;
+    std::map<QString, PostingList> loadedPostings;
+
+    quint32 documentTotal = 0;
+    in >> documentTotal;
+    // Uszkodzony licznik nie może wymusić ogromnej alokacji
+    const qint64 documentSize = sizeof(qint32) + sizeof(qint64);
+    loadedDocuments.reserve(static_cast<size_t>(qMin<qint64>(documentTotal, file.size() / documentSize)));
+    quint32 loadedRemoved = 0;
+    for (quint32 i = 0; i < documentTotal && in.status() == QDataStream::Ok; ++i) {
+        Document document{};
+        in >> document.friendId >> document.sequence;
+        loadedDocuments.push_back(document);
+        if (document.friendId < 0) ++loadedRemoved;
+    }
+    in >> loadedIndexed;
+
+    quint32 tokenTotal = 0;
+    in >> tokenTotal;
+    for (quint32 i = 0; i < tokenTotal && in.status() == QDataStream::Ok; ++i) {
+        QString token;
+        PostingList list;
+        in >> token >> list.count >> list.lastDocument >> list.deltas;
+        // Plik obcięty lub uszkodzony - indeks zostanie odbudowany z logów
+        if (in.status() != QDataStream::Ok || !isValid(list, static_cast<quint32>(loadedDocuments.size()))) {
+            return false;
+        }
+        loadedPostings.emplace(std::move(token), std::move(list));
+    }
+    if (in.status() != QDataStream::Ok || loadedDocuments.size() != documentTotal) return false;
+
+    QWriteLocker locker(&lock);
+    documents.swap(loadedDocuments);
+    indexed.swap(loadedIndexed);
+    postings.swap(loadedPostings);
+    removed = loadedRemoved;
+    return true;
+}
+
+void MessageSearchIndex::clear()
+{
+    QWriteLocker locker(&lock);
+    documents.clear();
+    indexed.clear();
+    postings.clear();
+    removed = 0;
+}
+
+int MessageSearchIndex::documentCount() const
+{
+    QReadLocker locker(&lock);
+    return static_cast<int>(documents.size());
+}
+
+int MessageSearchIndex::removedCount() const
+{
+    QReadLocker locker(&lock);
+    return static_cast<int>(removed);
+}
+
+int MessageSearchIndex::tokenCount() const
+{
+    QReadLocker locker(&lock);
+    return static_cast<int>(postings.size());
+}
@@ -0,0 +1,89 @@
+/**
+ * @file MessageSearchIndex.h
+ * @brief Full-text index over locally stored messages definition
+ * @author piotrek-pl
+ * @date 2025-02-08 16:41:05
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QByteArray>
+#include <QReadWriteLock>
+#include <map>
+#include <vector>
+
+/**
+ * Inverted index: token -> posting list of document ids. Document ids are
+ * assigned in insertion order, so every posting list is appended in
+ * ascending order and stored as varint-encoded deltas. Tokens live in a
+ * sorted map, which turns a prefix query into a contiguous range scan.
+ * Removed conversations leave tombstoned documents behind until compact()
+ * renumbers the live documents and rewrites the posting lists.
+ *
+ * Updated by the MessageStore writer thread; search() may be called from
+ * any thread.
+ */
+class MessageSearchIndex {
+public:
+    struct Hit {
+        int friendId;
+        qint64 sequence;  // Numer rekordu w logu rozmowy
+    };
+
+    MessageSearchIndex() = default;
+
+    static constexpr int COMPACT_MIN_REMOVED = 1024;
+
+    void add(int friendId, qint64 sequence, const QString& text);
+    // Unieważnia dokumenty rozmowy (po skróceniu jej logu)
+    void removeConversation(int friendId);
+    // Usunięte dokumenty to co najmniej COMPACT_MIN_REMOVED i ćwierć indeksu
+    bool needsCompaction() const;
+    // Usuwa unieważnione dokumenty; numeracja pozostałych się zmienia
+    void compact();
+    qint64 indexedCount(int friendId) const;
+
+    // Wszystkie słowa zapytania muszą wystąpić, każde jako prefiks tokenu.
+    // Wyniki od najnowszych.
+    QList<Hit> search(const QString& query, int limit) const;
+
+    bool save(const QString& path) const;
+    bool load(const QString& path);
+    void clear();
+
+    int documentCount() const;
+    int removedCount() const;
+    int tokenCount() const;
+
+    static QStringList tokenize(const QString& text);
+
+private:
+    struct PostingList {
+        QByteArray deltas;
+        quint32 count = 0;
+        quint32 lastDocument = 0;
+    };
+
+    struct Document {
+        qint32 friendId;   // -1 - dokument usunięty
+        qint64 sequence;
+    };
+
+    static constexpr int MAX_TOKEN_LENGTH = 32;
+
+    static void appendVarint(QByteArray& out, quint32 value);
+    static void decode(const PostingList& list, std::vector<quint32>& out);
+    // Lista z pliku: rosnące identyfikatory mniejsze od documentTotal, zgodne z count i lastDocument
+    static bool isValid(const PostingList& list, quint32 documentTotal);
+    std::vector<quint32> matchPrefix(const QString& prefix) const;
+
+    mutable QReadWriteLock lock;
+    std::map<QString, PostingList> postings;
+    std::vector<Document> documents;
+    QHash<int, qint64> indexed;  // Liczba zindeksowanych rekordów na rozmowę
+    quint32 removed = 0;         // Dokumenty z friendId -1
+};
@@ -0,0 +1,466 @@
+/**
+ * @file MessageStore.cpp
+ * @brief Local per-conversation message store implementation
+ * @author piotrek-pl
+ * @date 2025-02-08 10:12:47
+ */
+
+#include "MessageStore.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QtEndian>
+#include <cstring>
+#include "utils/Logger.h"
+
+namespace {
+const char LOG_MAGIC[4] = {'J', 'M', 'S', 'L'};
+const char INDEX_MAGIC[4] = {'J', 'M', 'S', 'I'};
+const qint64 RECORD_FIXED_SIZE = 8 + 1 + 2;  // timestamp + flags + długość nadawcy
+const quint8 FLAG_OWN = 0x01;
+const quint8 FLAG_MESSAGE_ID = 0x02;  // Po długości nadawcy 8 bajtów id z serwera
+}
+
+MessageStore::MessageStore()
+    : submitted(0)
+    , completed(0)
+    , stopping(false)
+    , unsavedDocuments(0)
+    , batches(0)
+    , records(0)
+{
+}
+
+MessageStore::~MessageStore()
+{
+    close();
+}
+
+MessageStore& MessageStore::getInstance()
+{
+    static MessageStore instance;
+    return instance;
+}
+
+void MessageStore::open(const QString& directory)
+{
+    if (directory == root && writerThread) return;
+
+    close();
+    if (!QDir().mkpath(directory)) {
+        LOG_WARNING(QString("Cannot create message store directory: %1").arg(directory));
+        return;
+    }
+
+    root = directory;
+    startWriter();
+    LOG_INFO(QString("Message store opened: %1").arg(root));
+}
+
+void MessageStore::close()
+{
+    // Wątek zapisu zapisuje indeks wyszukiwania przed zakończeniem
+    stopWriter();
+    conversations.clear();
+    index.clear();
+    root.clear();
+}
+
+bool MessageStore::isOpen() const
+{
+    return !root.isEmpty();
+}
+
+QString MessageStore::logPath(int friendId) const
+{
+    return QString("%1/%2.log").arg(root).arg(friendId);
+}
+
+QString MessageStore::indexPath(int friendId) const
+{
+    return QString("%1/%2.idx").arg(root).arg(friendId);
+}
+
+QString MessageStore::searchIndexPath() const
+{
+    return root + "/search.index";
+}
+
+void MessageStore::append(int friendId, QList<StoredMessage> messages)
+{
+    if (!isOpen() || messages.isEmpty()) return;
+
+    QMutexLocker locker(&queueMutex);
+    pending.append(Operation{friendId, false, std::move(messages)});
+    ++submitted;
+    wakeWriter.wakeOne();
+}
+
+void MessageStore::reset(int friendId, QList<StoredMessage> messages)
+{
+    if (!isOpen()) return;
+
+    QMutexLocker locker(&queueMutex);
+    pending.append(Operation{friendId, true, std::move(messages)});
+    ++submitted;
+    wakeWriter.wakeOne();
+}
+
+QByteArray MessageStore::encode(const StoredMessage& message)
+{
+    QByteArray sender = message.sender.toUtf8();
+    if (sender.size() > 0xFFFF) sender.truncate(0xFFFF);
+    const QByteArray content = message.content.toUtf8();
+
+    const qint64 idSize = message.messageId != 0 ? static_cast<qint64>(sizeof(qint64)) : 0;
+    const quint32 payloadSize = static_cast<quint32>(RECORD_FIXED_SIZE + idSize + sender.size() + content.size());
+    QByteArray data(static_cast<qsizetype>(sizeof(quint32) + payloadSize), Qt::Uninitialized);
+    uchar* out = reinterpret_cast<uchar*>(data.data());
+
+    qToLittleEndian<quint32>(payloadSize, out);
+    qToLittleEndian<qint64>(message.timestamp, out + 4);
+    out[12] = (message.isOwn ? FLAG_OWN : 0) | (idSize ? FLAG_MESSAGE_ID : 0);
+    qToLittleEndian<quint16>(static_cast<quint16>(sender.size()), out + 13);
+    if (idSize) {
+        qToLittleEndian<qint64>(message.messageId, out + 15);
+    }
+    uchar* text = out + 15 + idSize;
+    memcpy(text, sender.constData(), static_cast<size_t>(sender.size()));
+    memcpy(text + sender.size(), content.constData(), static_cast<size_t>(content.size()));
+    return data;
+}
+
+bool MessageStore::decode(const uchar* data, qint64 available, StoredMessage& message)
+{
+    if (available < static_cast<qint64>(sizeof(quint32))) return false;
+
+    const quint32 payloadSize = qFromLittleEndian<quint32>(data);
+    if (payloadSize < RECORD_FIXED_SIZE || sizeof(quint32) + payloadSize > static_cast<quint64>(available)) {
+        return false;
+    }
+
+    // Rekordy bez flagi id (sprzed jej wprowadzenia) czytane jak dotąd
+    const quint8 flags = data[12];
+    const qint64 idSize = (flags & FLAG_MESSAGE_ID) ? static_cast<qint64>(sizeof(qint64)) : 0;
+    const quint16 senderSize = qFromLittleEndian<quint16>(data + 13);
+    if (RECORD_FIXED_SIZE + idSize + senderSize > payloadSize) return false;
+
+    const uchar* text = data + 15 + idSize;
+    message.timestamp = qFromLittleEndian<qint64>(data + 4);
+    message.isOwn = (flags & FLAG_OWN) != 0;
+    message.messageId = idSize ? qFromLittleEndian<qint64>(data + 15) : 0;
+    message.sender = QString::fromUtf8(reinterpret_cast<const char*>(text), senderSize);
+    message.content = QString::fromUtf8(reinterpret_cast<const char*>(text + senderSize),
+                                        static_cast<qsizetype>(payloadSize - RECORD_FIXED_SIZE - idSize - senderSize));
+    return true;
+}
+
+qint64 MessageStore::recordCount(int friendId) const
+{
+    const qint64 size = QFileInfo(indexPath(friendId)).size();
+    return size > HEADER_SIZE ? (size - HEADER_SIZE) / static_cast<qint64>(sizeof(quint64)) : 0;
+}
+
+QList<MessageStore::StoredMessage> MessageStore::readRange(int friendId, qint64 first, qint64 count) const
+{
+    QList<StoredMessage> result;
+
+    QFile indexFile(indexPath(friendId));
+    QFile log(logPath(friendId));
+    if (!indexFile.open(QIODevice::ReadOnly) || !log.open(QIODevice::ReadOnly)) return result;
+
+    const qint64 total = (indexFile.size() - HEADER_SIZE) / static_cast<qint64>(sizeof(quint64));
+    const qint64 logSize = log.size();
+    first = qMax<qint64>(0, first);
+    count = qMin(count, total - first);
+    if (count <= 0 || logSize <= HEADER_SIZE) return result;
+
+    const uchar* offsets = indexFile.map(HEADER_SIZE + first * sizeof(quint64), count * sizeof(quint64));
+    const uchar* logData = log.map(0, logSize);
+    if (!offsets || !logData || memcmp(logData, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) return result;
+
+    result.reserve(static_cast<qsizetype>(count));
+    for (qint64 i = 0; i < count; ++i) {
+        const quint64 offset = qFromLittleEndian<quint64>(offsets + i * sizeof(quint64));
+        if (offset < HEADER_SIZE || offset >= static_cast<quint64>(logSize)) break;
+
+        StoredMessage message;
+        if (!decode(logData + offset, logSize - static_cast<qint64>(offset), message)) break;
+        result.append(std::move(message));
+    }
+    // Mapowania zwalnia QFile przy zamknięciu
+    return result;
+}
+
+QList<MessageStore::StoredMessage> MessageStore::readLatest(int friendId, int limit) const
+{
+    if (!isOpen() || limit <= 0) return {};
+
+    // Blokada do odczytu: wątek zapisu nie zmienia plików ani kolejki w trakcie
+    QReadLocker filesLocker(&filesLock);
+
+    QList<Operation> queued;
+    {
+        QMutexLocker locker(&queueMutex);
+        queued = pending;
+    }
+
+    // Ostatnie niezapisane skrócenie rozmowy zastępuje zawartość dysku
+    qsizetype start = 0;
+    bool fromDisk = true;
+    for (qsizetype i = queued.size() - 1; i >= 0; --i) {
+        if (queued[i].friendId == friendId && queued[i].truncate) {
+            start = i;
+            fromDisk = false;
+            break;
+        }
+    }
+
+    QList<StoredMessage> result;
+    if (fromDisk) {
+        result = readRange(friendId, recordCount(friendId) - limit, limit);
+    }
+    for (qsizetype i = start; i < queued.size(); ++i) {
+        if (queued[i].friendId == friendId) {
+            result.append(queued[i].messages);
+        }
+    }
+
+    if (result.size() > limit) {
+        result.remove(0, result.size() - limit);
+    }
+    return result;
+}
+
+QList<MessageStore::SearchResult> MessageStore::search(const QString& query, int limit) const
+{
+    QList<SearchResult> results;
+    if (!isOpen()) return results;
+
+    QReadLocker filesLocker(&filesLock);
+    for (const MessageSearchIndex::Hit& hit : index.search(query, limit)) {
+        QList<StoredMessage> record = readRange(hit.friendId, hit.sequence, 1);
+        if (!record.isEmpty()) {
+            results.append(SearchResult{hit.friendId, hit.sequence, std::move(record.first())});
+        }
+    }
+    return results;
+}
+
+void MessageStore::flush()
+{
+    QMutexLocker locker(&queueMutex);
+    const quint64 target = submitted;
+    while (completed < target && writerThread) {
+        wakeWriter.wakeOne();
+        committed.wait(&queueMutex, 100);
+    }
+}
+
+void MessageStore::startWriter()
+{
+    {
+        QMutexLocker locker(&queueMutex);
+        stopping = false;
+        ++submitted;  // Uzupełnienie indeksu wyszukiwania - flush() czeka także na nie
+    }
+    writerThread.reset(QThread::create([this]() { writerLoop(); }));
+    writerThread->setObjectName("MessageStoreWriter");
+    writerThread->start(QThread::LowPriority);
+}
+
+void MessageStore::stopWriter()
+{
+    if (!writerThread) return;
+
+    {
+        QMutexLocker locker(&queueMutex);
+        stopping = true;
+        wakeWriter.wakeAll();
+    }
+    // Wątek zapisu opróżnia kolejkę przed zakończeniem
+    writerThread->wait();
+    writerThread.reset();
+}
+
+void MessageStore::writerLoop()
+{
+    catchUpSearchIndex();
+    {
+        QMutexLocker locker(&queueMutex);
+        ++completed;
+        committed.wakeAll();
+    }
+
+    while (true) {
+        QList<Operation> batch;
+        {
+            QMutexLocker locker(&queueMutex);
+            while (pending.isEmpty() && !stopping) {
+                wakeWriter.wait(&queueMutex);
+            }
+            if (pending.isEmpty()) break;
+            batch = pending;
+        }
+
+        QWriteLocker filesLocker(&filesLock);
+        commit(batch);
+
+        // Operacje znikają z kolejki dopiero po zapisie - odczyt widzi je zawsze w jednym miejscu
+        QMutexLocker locker(&queueMutex);
+        pending.remove(0, batch.size());
+        completed += batch.size();
+        committed.wakeAll();
+        locker.unlock();
+        filesLocker.unlock();
+
+        if (unsavedDocuments >= INDEX_SAVE_INTERVAL) {
+            saveSearchIndex();
+        }
+    }
+
+    saveSearchIndex();
+}
+
+void MessageStore::catchUpSearchIndex()
+{
+    // Indeks z dysku uzupełniamy o rekordy dopisane po jego ostatnim zapisie
+    if (!index.load(searchIndexPath())) {
+        index.clear();
+    }
+
+    const QStringList files = QDir(root).entryList({"*.idx"}, QDir::Files);
+    for (const QString& file : files) {
+        bool ok = false;
+        const int friendId = QFileInfo(file).completeBaseName().toInt(&ok);
+        if (!ok) continue;
+
+        const qint64 total = recordCount(friendId);
+        qint64 done = index.indexedCount(friendId);
+        if (total < done) {
+            // Log skrócony po zapisie indeksu - indeksujemy rozmowę od nowa
+            index.removeConversation(friendId);
+            done = 0;
+        }
+
+        while (done < total) {
+            const QList<StoredMessage> chunk = readRange(friendId, done, 4096);
+            if (chunk.isEmpty()) break;
+            for (const StoredMessage& message : chunk) {
+                index.add(friendId, done++, message.content);
+            }
+            unsavedDocuments += chunk.size();
+        }
+    }
+
+    if (unsavedDocuments > 0) {
+        saveSearchIndex();
+    }
+    LOG_INFO(QString("Search index ready: %1 messages, %2 tokens")
+                 .arg(index.documentCount()).arg(index.tokenCount()));
+}
+
+void MessageStore::saveSearchIndex()
+{
+    if (unsavedDocuments == 0) return;
+
+    // Każda luka w historii (reset rozmowy) zostawia w indeksie usunięte dokumenty
+    if (index.needsCompaction()) {
+        LOG_INFO(QString("Compacting search index: %1 of %2 documents removed")
+                     .arg(index.removedCount()).arg(index.documentCount()));
+        index.compact();
+    }
+
+    if (index.save(searchIndexPath())) {
+        unsavedDocuments = 0;
+    } else {
+        LOG_WARNING(QString("Cannot save search index: %1").arg(searchIndexPath()));
+    }
+}
+
+MessageStore::Conversation* MessageStore::conversationFor(int friendId, bool truncate)
+{
+    auto it = conversations.find(friendId);
+    if (it != conversations.end()) {
+        if (!truncate) return &it->second;
+        conversations.erase(it);
+    }
+
+    auto openFile = [truncate](const QString& path, const char* magic, qint64 recordAlign) {
+        auto file = std::make_unique<QFile>(path);
+        if (!file->open(QIODevice::ReadWrite)) return std::unique_ptr<QFile>();
+
+        char header[HEADER_SIZE];
+        const bool valid = !truncate
+                           && file->read(header, HEADER_SIZE) == HEADER_SIZE
+                           && memcmp(header, magic, 4) == 0
+                           && qFromLittleEndian<quint32>(header + 4) == FORMAT_VERSION;
+        if (!valid) {
+            file->resize(0);
+            qToLittleEndian<quint32>(FORMAT_VERSION, header + 4);
+            memcpy(header, magic, 4);
+            file->seek(0);
+            file->write(header, HEADER_SIZE);
+        } else if (recordAlign > 1) {
+            // Niepełny wpis indeksu po przerwanym zapisie
+            const qint64 body = file->size() - HEADER_SIZE;
+            file->resize(HEADER_SIZE + body - body % recordAlign);
+        }
+        file->seek(file->size());
+        return file;
+    };
+
+    Conversation conversation;
+    conversation.log = openFile(logPath(friendId), LOG_MAGIC, 1);
+    conversation.index = openFile(indexPath(friendId), INDEX_MAGIC, sizeof(quint64));
+    if (!conversation.log || !conversation.index) {
+        LOG_WARNING(QString("Cannot open message store for conversation %1").arg(friendId));
+        return nullptr;
+    }
+    conversation.count = (conversation.index->size() - HEADER_SIZE) / static_cast<qint64>(sizeof(quint64));
+    if (truncate) {
+        index.removeConversation(friendId);
+    }
+
+    return &conversations.emplace(friendId, std::move(conversation)).first->second;
+}
+
+void MessageStore::commit(QList<Operation>& batch)
+{
+    // Wpisy indeksu trafiają na dysk po rekordach, na które wskazują
+    QHash<int, QByteArray> indexEntries;
+    quint64 written = 0;
+
+    for (Operation& operation : batch) {
+        if (operation.truncate) {
+            indexEntries.remove(operation.friendId);
+        }
+
+        Conversation* conversation = conversationFor(operation.friendId, operation.truncate);
+        if (!conversation) continue;
+
+        QByteArray& entries = indexEntries[operation.friendId];
+        for (const StoredMessage& message : operation.messages) {
+            const quint64 offset = static_cast<quint64>(conversation->log->pos());
+            conversation->log->write(encode(message));
+
+            char entry[sizeof(quint64)];
+            qToLittleEndian<quint64>(offset, entry);
+            entries.append(entry, sizeof(entry));
+            index.add(operation.friendId, conversation->count++, message.content);
+            ++written;
+        }
+    }
+
+    // Jeden flush na plik dla całej partii
+    for (auto it = indexEntries.constBegin(); it != indexEntries.constEnd(); ++it) {
+        Conversation& conversation = conversations.at(it.key());
+        conversation.log->flush();
+        conversation.index->write(it.value());
+        conversation.index->flush();
+    }
+
+    ++batches;
+    records += written;
+    unsavedDocuments += written;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file MessageStore.h
+ * @brief Local per-conversation message store definition
+ * @author piotrek-pl
+ * @date 2025-02-08 10:12:47
+ */
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QWaitCondition>
+#include <QThread>
+#include <QFile>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include "MessageSearchIndex.h"
+
+/**
+ * Append-only message log per conversation, stored in a user directory as
+ * <friendId>.log (records) and <friendId>.idx (one 64-bit log offset per
+ * record). Reads memory-map both files; writes are queued and committed by
+ * a background thread, one flush per file per batch. The same thread keeps
+ * a full-text index of all conversations up to date (search.index).
+ *
+ * Record layout (little endian), preceded in the log by an 8-byte header:
+ *   quint32 payload size | qint64 timestamp (ms) | quint8 flags |
+ *   quint16 sender size | [qint64 server message id, if flagged] |
+ *   sender (UTF-8) | content (UTF-8)
+ */
+class MessageStore {
+public:
+    struct StoredMessage {
+        QString sender;
+        QString content;
+        qint64 timestamp = 0;  // ms od epoki
+        bool isOwn = false;
+        qint64 messageId = 0;  // Id z serwera, 0 - nieznane (np. własna, jeszcze niepotwierdzona)
+    };
+
+    struct SearchResult {
+        int friendId;
+        qint64 sequence;
+        StoredMessage message;
+    };
+
+    static MessageStore& getInstance();
+
+    // Katalog bieżącego użytkownika; zapisuje wcześniej zakolejkowane zmiany
+    void open(const QString& directory);
+    void close();
+    bool isOpen() const;
+
+    // Zapis asynchroniczny, kolejność w obrębie rozmowy zachowana
+    void append(int friendId, QList<StoredMessage> messages);
+    // Zastępuje całą rozmowę (np. gdy między cache a serwerem jest luka)
+    void reset(int friendId, QList<StoredMessage> messages);
+
+    // Najnowsze wiadomości w kolejności chronologicznej, łącznie z niezapisanymi
+    QList<StoredMessage> readLatest(int friendId, int limit) const;
+
+    // Czeka, aż zakolejkowane zmiany trafią na dysk
+    void flush();
+
+    // Wyszukiwanie we wszystkich rozmowach (zapisanych na dysku), od najnowszych
+    QList<SearchResult> search(const QString& query, int limit) const;
+    const MessageSearchIndex& searchIndex() const { return index; }
+
+    quint64 committedBatches() const { return batches.load(); }
+    quint64 committedRecords() const { return records.load(); }
+
+private:
+    MessageStore();
+    ~MessageStore();
+    MessageStore(const MessageStore&) = delete;
+    MessageStore& operator=(const MessageStore&) = delete;
+
+    struct Operation {
+        int friendId;
+        bool truncate;
+        QList<StoredMessage> messages;
+    };
+
+    struct Conversation {
+        std::unique_ptr<QFile> log;
+        std::unique_ptr<QFile> index;
+        qint64 count = 0;  // Liczba rekordów, kolejny numer sekwencyjny
+    };
+
+    static constexpr int HEADER_SIZE = 8;
+    static constexpr quint32 FORMAT_VERSION = 1;
+    static constexpr quint64 INDEX_SAVE_INTERVAL = 10000;  // Dokumenty między zapisami indeksu
+
+    QString logPath(int friendId) const;
+    QString indexPath(int friendId) const;
+    QString searchIndexPath() const;
+    static QByteArray encode(const StoredMessage& message);
+    static bool decode(const uchar* data, qint64 available, StoredMessage& message);
+    qint64 recordCount(int friendId) const;
+    QList<StoredMessage> readRange(int friendId, qint64 first, qint64 count) const;
+
+    // Wątek zapisu
+    void startWriter();
+    void stopWriter();
+    void writerLoop();
+    void commit(QList<Operation>& batch);
+    Conversation* conversationFor(int friendId, bool truncate);
+    void catchUpSearchIndex();
+    void saveSearchIndex();
+
+    QString root;  // Zmieniany tylko przy zatrzymanym wątku zapisu
+    mutable QReadWriteLock filesLock;  // Skracanie plików vs odczyt przez mmap
+    std::unordered_map<int, Conversation> conversations;  // Tylko wątek zapisu
+    MessageSearchIndex index;                              // Zapis tylko z wątku zapisu
+    quint64 unsavedDocuments;                              // Tylko wątek zapisu
+
+    mutable QMutex queueMutex;
+    QWaitCondition wakeWriter;
+    QWaitCondition committed;
+    QList<Operation> pending;
+    quint64 submitted;       // Chronione przez queueMutex
+    quint64 completed;       // Chronione przez queueMutex
+    bool stopping;           // Chronione przez queueMutex
+    std::unique_ptr<QThread> writerThread;
+    std::atomic<quint64> batches;
+    std::atomic<quint64> records;
+};
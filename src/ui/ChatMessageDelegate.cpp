@@ -0,0 +1,97 @@
+/**
+ * @file ChatMessageDelegate.cpp
+ * @brief Chat transcript row delegate implementation
+ * @author piotrek-pl
+ * @date 2025-02-07 11:04:39
+ */
+
+#include "ChatMessageDelegate.h"
+#include "ChatTranscriptModel.h"
+#include <QPainter>
+#include <QDateTime>
+#include <climits>
+
+ChatMessageDelegate::ChatMessageDelegate(QAbstractItemView* view)
+    : QStyledItemDelegate(view)
+    , view(view)
+    , heightSum(0)
+    , cachedWidth(-1)
+{
+}
+
+QRect ChatMessageDelegate::contentRect(const QStyleOptionViewItem& option, int headerHeight) const
+{
+    return option.rect.adjusted(PADDING, PADDING + headerHeight, -PADDING, -PADDING);
+}
+
+void ChatMessageDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                                const QModelIndex& index) const
+{
+    const QString sender = index.data(ChatTranscriptModel::SenderRole).toString();
+    const QString content = index.data(ChatTranscriptModel::ContentRole).toString();
+    const qint64 timestamp = index.data(ChatTranscriptModel::TimestampRole).toLongLong();
+
+    painter->save();
+    painter->setClipRect(option.rect);
+
+    QFont boldFont = option.font;
+    boldFont.setBold(true);
+    const QFontMetrics boldMetrics(boldFont);
+    const QRect headerRect = option.rect.adjusted(PADDING, PADDING, -PADDING, 0);
+
+    painter->setPen(option.palette.color(QPalette::Text));
+    painter->setFont(boldFont);
+    painter->drawText(headerRect, Qt::AlignLeft | Qt::AlignTop, sender);
+
+    const int senderWidth = boldMetrics.horizontalAdvance(sender);
+    painter->setFont(option.font);
+    painter->drawText(headerRect.adjusted(senderWidth, 0, 0, 0), Qt::AlignLeft | Qt::AlignTop,
+                      QString(" [%1]").arg(QDateTime::fromMSecsSinceEpoch(timestamp).toString("HH:mm:ss")));
+
+    painter->drawText(contentRect(option, boldMetrics.height()),
+                      Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, content);
+
+    painter->restore();
+}
+
+QSize ChatMessageDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    const int viewportWidth = view ? view->viewport()->width() : option.rect.width();
+    const int width = viewportWidth > 0 ? viewportWidth : 300;
+    if (width != cachedWidth) {
+        heights.clear();
+        heightSum = 0;
+        cachedWidth = width;
+    }
+
+    const quint64 key = index.data(ChatTranscriptModel::KeyRole).toULongLong();
+    auto it = heights.constFind(key);
+    if (it != heights.constEnd()) {
+        return QSize(width, *it);
+    }
+
+    QFont boldFont = option.font;
+    boldFont.setBold(true);
+    const int headerHeight = QFontMetrics(boldFont).height();
+
+    const QString content = index.data(ChatTranscriptModel::ContentRole).toString();
+    const QRect bounds = option.fontMetrics.boundingRect(
+        QRect(0, 0, qMax(1, width - 2 * PADDING), INT_MAX),
+        Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, content);
+
+    const int height = headerHeight + bounds.height() + 2 * PADDING;
+    heights.insert(key, height);
+    heightSum += height;
+    return QSize(width, height);
+}
+
+int ChatMessageDelegate::averageHeight(const QFont& font) const
+{
+    if (!heights.isEmpty()) {
+        return static_cast<int>(heightSum / heights.size());
+    }
+
+    QFont boldFont = font;
+    boldFont.setBold(true);
+    return QFontMetrics(boldFont).height() + QFontMetrics(font).height() + 2 * PADDING;
+}
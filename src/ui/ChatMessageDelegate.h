@@ -0,0 +1,47 @@
+/**
+ * @file ChatMessageDelegate.h
+ * @brief Chat transcript row delegate definition
+ * @author piotrek-pl
+ * @date 2025-02-07 11:04:39
+ */
+
+#pragma once
+
+#include <QStyledItemDelegate>
+#include <QAbstractItemView>
+#include <QHash>
+#include <QPointer>
+
+/**
+ * Paints one transcript row: bold sender, time and word-wrapped content.
+ * Row heights are cached per message key for the current viewport width;
+ * the cache is dropped only when the width changes.
+ */
+class ChatMessageDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    // Szerokość wierszy brana jest z viewportu widoku
+    explicit ChatMessageDelegate(QAbstractItemView* view);
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+    void forget(quint64 key) { heightSum -= heights.take(key); }
+    void forgetAll() { heights.clear(); heightSum = 0; }
+    int cachedLayouts() const { return heights.size(); }
+
+    // Średnia z policzonych wierszy, przed pierwszym układem - wiersz jednolinijkowy
+    int averageHeight(const QFont& font) const;
+
+private:
+    static constexpr int PADDING = 6;
+
+    QRect contentRect(const QStyleOptionViewItem& option, int headerHeight) const;
+
+    QPointer<QAbstractItemView> view;
+    mutable QHash<quint64, int> heights;
+    mutable qint64 heightSum;
+    mutable int cachedWidth;
+};
@@ -0,0 +1,138 @@
+/**
+ * @file ChatTranscriptModel.cpp
+ * @brief Chat transcript list model implementation
+ * @author piotrek-pl
+ * @date 2025-02-07 11:04:39
+ */
+
+#include "ChatTranscriptModel.h"
+#include <QDateTime>
+
+ChatTranscriptModel::ChatTranscriptModel(QObject* parent)
+    : QAbstractListModel(parent)
+    , nextKey(1)
+    , bytes(0)
+{
+}
+
+int ChatTranscriptModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : records.size();
+}
+
+QVariant ChatTranscriptModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= records.size()) return QVariant();
+
+    const MessageRecord& record = records[index.row()];
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("%1 [%2]\n%3")
+            .arg(record.sender,
+                 QDateTime::fromMSecsSinceEpoch(record.timestamp).toString("HH:mm:ss"),
+                 record.content);
+    case SenderRole:
+        return record.sender;
+    case ContentRole:
+        return record.content;
+    case TimestampRole:
+        return record.timestamp;
+    case OwnRole:
+        return record.isOwn;
+    case KeyRole:
+        return record.key;
+    default:
+        return QVariant();
+    }
+}
+
+qint64 ChatTranscriptModel::recordSize(const MessageRecord& record)
+{
+    return static_cast<qint64>(sizeof(MessageRecord))
+           + (record.sender.size() + record.content.size()) * static_cast<qint64>(sizeof(QChar));
+}
+
+void ChatTranscriptModel::assignKeys(QList<MessageRecord>& batch)
+{
+    for (MessageRecord& record : batch) {
+        record.key = nextKey++;
+        bytes += recordSize(record);
+    }
+}
+
+void ChatTranscriptModel::appendMessage(MessageRecord record)
+{
+    record.key = nextKey++;
+    bytes += recordSize(record);
+    beginInsertRows(QModelIndex(), records.size(), records.size());
+    records.append(std::move(record));
+    endInsertRows();
+}
+
+void ChatTranscriptModel::appendMessages(QList<MessageRecord> batch)
+{
+    if (batch.isEmpty()) return;
+
+    assignKeys(batch);
+    beginInsertRows(QModelIndex(), records.size(), records.size() + batch.size() - 1);
+    records.append(std::move(batch));
+    endInsertRows();
+}
+
+void ChatTranscriptModel::prependMessages(QList<MessageRecord> batch)
+{
+    if (batch.isEmpty()) return;
+
+    assignKeys(batch);
+    beginInsertRows(QModelIndex(), 0, batch.size() - 1);
+    // QList w Qt 6 utrzymuje wolne miejsce na początku - koszt zależy od rozmiaru partii
+    for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+        records.prepend(std::move(*it));
+    }
+    endInsertRows();
+}
+
+void ChatTranscriptModel::clear()
+{
+    if (records.isEmpty()) return;
+
+    beginResetModel();
+    records.clear();
+    bytes = 0;
+    endResetModel();
+}
+
+QList<quint64> ChatTranscriptModel::evictFront(int count)
+{
+    count = qMin(count, static_cast<int>(records.size()));
+    QList<quint64> keys;
+    if (count <= 0) return keys;
+
+    keys.reserve(count);
+    beginRemoveRows(QModelIndex(), 0, count - 1);
+    for (int i = 0; i < count; ++i) {
+        keys.append(records[i].key);
+        bytes -= recordSize(records[i]);
+    }
+    records.remove(0, count);
+    endRemoveRows();
+    return keys;
+}
+
+QList<quint64> ChatTranscriptModel::evictBack(int count)
+{
+    count = qMin(count, static_cast<int>(records.size()));
+    QList<quint64> keys;
+    if (count <= 0) return keys;
+
+    const int first = records.size() - count;
+    keys.reserve(count);
+    beginRemoveRows(QModelIndex(), first, records.size() - 1);
+    for (int i = first; i < records.size(); ++i) {
+        keys.append(records[i].key);
+        bytes -= recordSize(records[i]);
+    }
+    records.remove(first, count);
+    endRemoveRows();
+    return keys;
+}
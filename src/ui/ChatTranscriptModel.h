@@ -0,0 +1,69 @@
+/**
+ * @file ChatTranscriptModel.h
+ * @brief Chat transcript list model definition
+ * @author piotrek-pl
+ * @date 2025-02-07 11:04:39
+ */
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QString>
+
+/**
+ * Compact message records for a single conversation.
+ * Each record gets a model-unique key, so cached layout data survives
+ * row shifts caused by prepending older history. The model tracks an
+ * approximate byte footprint so the owning window can keep it under budget
+ * by evicting rows from either end.
+ */
+class ChatTranscriptModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    struct MessageRecord {
+        QString sender;
+        QString content;
+        qint64 timestamp = 0;  // ms od epoki
+        bool isOwn = false;
+        qint64 messageId = 0;  // Identyfikator z serwera, 0 - serwer go nie podaje
+        quint64 key = 0;       // Nadawany przez model
+    };
+
+    enum Roles {
+        SenderRole = Qt::UserRole,
+        ContentRole,
+        TimestampRole,
+        OwnRole,
+        KeyRole
+    };
+
+    explicit ChatTranscriptModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    const MessageRecord& recordAt(int row) const { return records[row]; }
+
+    void appendMessage(MessageRecord record);
+    void appendMessages(QList<MessageRecord> batch);
+    // Starsze wiadomości w kolejności chronologicznej
+    void prependMessages(QList<MessageRecord> batch);
+    void clear();
+
+    // Usuwają wiersze z początku / końca, zwracają klucze usuniętych rekordów
+    QList<quint64> evictFront(int count);
+    QList<quint64> evictBack(int count);
+
+    // Przybliżony rozmiar rekordów w pamięci (bajty)
+    qint64 memoryUsage() const { return bytes; }
+    static qint64 recordSize(const MessageRecord& record);
+
+private:
+    void assignKeys(QList<MessageRecord>& batch);
+
+    QList<MessageRecord> records;
+    quint64 nextKey;
+    qint64 bytes;
+};
@@ -3,36 +3,150 @@
 #include "ChatWindow.h"
 #include "ui_ChatWindow.h"
 #include <QScrollBar>
-#include <QTextCursor>
+#include <QCloseEvent>
+#include <algorithm>
 #include "network/Protocol.h"
+#include "storage/MessageStore.h"
 #include "utils/Logger.h" // Assuming a LOG_INFO or similar macro is defined here
 
-ChatWindow::ChatWindow(const QString& friendName, int friendId, QWidget *parent)
+namespace {
+MessageStore::StoredMessage toStored(const ChatTranscriptModel::MessageRecord& record)
+{
+    return MessageStore::StoredMessage{record.sender, record.content, record.timestamp, record.isOwn,
+                                       record.messageId};
+}
+
+QList<MessageStore::StoredMessage> toStored(const QList<ChatTranscriptModel::MessageRecord>& records)
+{
+    QList<MessageStore::StoredMessage> stored;
+    stored.reserve(records.size());
+    for (const ChatTranscriptModel::MessageRecord& record : records) {
+        stored.append(toStored(record));
+    }
+    return stored;
+}
+
+ChatTranscriptModel::MessageRecord fromStored(const MessageStore::StoredMessage& message)
+{
+    ChatTranscriptModel::MessageRecord record;
+    record.sender = message.sender;
+    record.content = message.content;
+    record.timestamp = message.timestamp;
+    record.isOwn = message.isOwn;
+    record.messageId = message.messageId;
+    return record;
+}
+
+// Pozycja rekordu z dysku na stronie z serwera, -1 gdy go tam nie ma. Id z serwera
+// rozstrzyga; bez niego własne wiadomości mają lokalny czas wysłania, a serwer zapisuje
+// swój, więc spośród zgodnych treścią w oknie 60 s wygrywa najbliższy czas.
+qsizetype findOverlap(const QList<ChatTranscriptModel::MessageRecord>& page,
+                      const ChatTranscriptModel::MessageRecord& cached)
+{
+    qsizetype best = -1;
+    qint64 bestDistance = 60001;
+    for (qsizetype i = 0; i < page.size(); ++i) {
+        const ChatTranscriptModel::MessageRecord& candidate = page[i];
+        if (cached.messageId != 0 && candidate.messageId != 0) {
+            if (candidate.messageId == cached.messageId) return i;
+            continue;
+        }
+        if (candidate.sender != cached.sender || candidate.content != cached.content) continue;
+
+        const qint64 distance = qAbs(candidate.timestamp - cached.timestamp);
+        if (distance < bestDistance) {
+            best = i;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+}
+
+ChatWindow::ChatWindow(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::ChatWindow)
     , networkManager(NetworkManager::getInstance())
-    , friendName(friendName)
-    , friendId(friendId)
+    , transcriptModel(nullptr)
+    , transcriptDelegate(nullptr)
+    , friendId(NO_FRIEND)
     , currentOffset(0)
+    , newerOffset(0)
     , hasMoreMessages(true)
     , isLoadingHistory(false)
-    , messagesMarkedAsRead(false)
+    , lastIncomingTimestamp(0)
+    , pendingOffset(0)
+    , chatConfig(ConfigManager::getInstance().getChatConfig())
+    , evictedTotal(0)
+    , reconcilePending(false)
+    , cachedRows(0)
+    , storeDetached(false)
+    , awaitingPrefetch(false)
+    , adjustingScroll(false)
 {
     ui->setupUi(this);
-    setWindowTitle("Chat with " + friendName);
+    // Tło z arkusza aplikacji (reguła "ChatWindow")
+    setAttribute(Qt::WA_StyledBackground);
+    transcriptModel = new ChatTranscriptModel(this);
+    transcriptDelegate = new ChatMessageDelegate(ui->transcriptView);
     initializeUI();
+}
+
+ChatWindow::ChatWindow(const QString& friendName, int friendId, QWidget *parent)
+    : ChatWindow(parent)
+{
+    bind(friendName, friendId);
+}
+
+ChatWindow::~ChatWindow()
+{
+    delete ui;
+}
+
+void ChatWindow::bind(const QString& friendName, int friendId)
+{
+    if (this->friendId != NO_FRIEND) {
+        reset();
+    }
+
+    this->friendName = friendName;
+    this->friendId = friendId;
+    chatConfig = ConfigManager::getInstance().getChatConfig();
+    setWindowTitle("Chat with " + friendName);
 
-    // Setup our dispatch map
     setupMessageHandlers();
     loadInitialHistory();
+}
 
-    connect(&networkManager, &NetworkManager::messageReceived,
-            this, &ChatWindow::onMessageReceived);
+void ChatWindow::reset()
+{
+    networkManager.router().unsubscribe(this);
+    // Odpowiedzi dla poprzedniego rozmówcy nie mogą trafić do nowego
+    networkManager.requests().cancel(this);
+    clearTranscript();
+    ui->messageLineEdit->clear();
+    setWindowTitle(QString());
+
+    friendName.clear();
+    friendId = NO_FRIEND;
+    currentOffset = 0;
+    newerOffset = 0;
+    hasMoreMessages = true;
+    isLoadingHistory = false;
+    lastIncomingTimestamp = 0;
+    pendingOffset = 0;
+    evictedTotal = 0;
+    reconcilePending = false;
+    cachedRows = 0;
+    storeDetached = false;
 }
 
-ChatWindow::~ChatWindow()
+void ChatWindow::clearTranscript()
 {
-    delete ui;
+    cancelPrefetch();
+    prefetcher.clearPages();
+    transcriptDelegate->forgetAll();
+    transcriptModel->clear();
 }
 
 void ChatWindow::initializeUI()
@@ -41,129 +155,118 @@ void ChatWindow::initializeUI()
             this, &ChatWindow::onSendMessageClicked);
     connect(ui->messageLineEdit, &QLineEdit::returnPressed,
             this, &ChatWindow::onSendMessageClicked);
-    connect(ui->chatTextEdit->verticalScrollBar(), &QScrollBar::valueChanged,
+    connect(ui->transcriptView->verticalScrollBar(), &QScrollBar::valueChanged,
             this, &ChatWindow::onScrollValueChanged);
 
-    ui->chatTextEdit->setReadOnly(true);
+    // Widok układa tylko widoczne wiersze, wysokości cache'uje delegat
+    ui->transcriptView->setModel(transcriptModel);
+    ui->transcriptView->setItemDelegate(transcriptDelegate);
+    ui->transcriptView->setSelectionMode(QAbstractItemView::NoSelection);
+    ui->transcriptView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    ui->transcriptView->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    ui->transcriptView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    ui->transcriptView->setResizeMode(QListView::Adjust);
+    ui->transcriptView->setLayoutMode(QListView::Batched);
+    ui->transcriptView->setBatchSize(50);
 }
 
 void ChatWindow::setupMessageHandlers()
 {
-    using namespace Protocol::MessageType;
-
-    // Combine LATEST_MESSAGES_RESPONSE, CHAT_HISTORY_RESPONSE, and MORE_HISTORY_RESPONSE
-    // into one handler for clarity:
-    messageHandlers[LATEST_MESSAGES_RESPONSE] = [&](const QJsonObject& json) {
-        handleHistoryResponse(json);
-    };
-    messageHandlers[CHAT_HISTORY_RESPONSE] = [&](const QJsonObject& json) {
-        handleHistoryResponse(json);
-    };
-    messageHandlers[MORE_HISTORY_RESPONSE] = [&](const QJsonObject& json) {
-        handleHistoryResponse(json);
-    };
-
-    messageHandlers[MESSAGE_RESPONSE] = [&](const QJsonObject& json) {
-        handleMessageResponse(json);
-    };
-    messageHandlers[NEW_MESSAGES] = [&](const QJsonObject& json) {
+    using Protocol::MessageType::Id;
+    MessageRouter& router = networkManager.router();
+
+    // Router dostarcza tylko ramki tego rozmówcy.
+    // MESSAGE_RESPONSE przekazuje MainWindow przez processMessage(),
+    // odpowiedzi na własne żądania historii - requestHistory().
+    router.subscribePeer(this, Id::CHAT_HISTORY_RESPONSE, friendId, [this](const QJsonObject& json) {
+        handleHistoryResponse(Id::CHAT_HISTORY_RESPONSE, json);
+    });
+    router.subscribePeer(this, Id::NEW_MESSAGES, friendId, [this](const QJsonObject& json) {
         handleNewMessages(json);
-    };
+    });
 }
 
-void ChatWindow::onMessageReceived(const QJsonObject& json)
+QList<ChatTranscriptModel::MessageRecord> ChatWindow::recordsFromJson(const QJsonArray& messages) const
 {
-    QString type = json["type"].toString();
-
-    // Jeśli to nowa wiadomość, obsługuj ją tylko gdy przychodzi bezpośrednio z NetworkManager
-    if (type == Protocol::MessageType::NEW_MESSAGES && !sender()) {
-        // Ignoruj wiadomości przekazane z MainWindow (gdy sender() == nullptr)
-        return;
-    }
-
-    LOG_INFO(QString("ChatWindow::onMessageReceived - Received message type: %1").arg(type));
-    dispatchMessage(json);
-}
-
-void ChatWindow::dispatchMessage(const QJsonObject& json)
-{
-    QString type = json["type"].toString();
-    LOG_INFO(QString("ChatWindow::onMessageReceived - Received message type: %1").arg(type));
-
-    // Look for a matching handler
-    auto it = messageHandlers.find(type);
-    if (it != messageHandlers.end()) {
-        it->second(json);
-    } else {
-        LOG_INFO("ChatWindow::dispatchMessage - Unknown message type received.");
+    QList<ChatTranscriptModel::MessageRecord> batch;
+    batch.reserve(messages.size());
+    for (const QJsonValue& msgVal : messages)
+    {
+        QJsonObject msg = msgVal.toObject();
+        ChatTranscriptModel::MessageRecord record;
+        record.sender = msg["sender"].toString();
+        record.content = msg["content"].toString();
+        record.timestamp = QDateTime::fromString(msg["timestamp"].toString(), Qt::ISODate).toMSecsSinceEpoch();
+        record.isOwn = (record.sender != friendName);
+        record.messageId = msg.contains("id") ? msg["id"].toInteger() : msg["message_id"].toInteger();
+        batch.append(std::move(record));
     }
+    return batch;
 }
 
-void ChatWindow::handleHistoryResponse(const QJsonObject& json)
+void ChatWindow::handleHistoryResponse(Protocol::MessageType::Id type, const QJsonObject& json)
 {
-    QJsonArray messages = json["messages"].toArray();
-    int oldScrollPos = ui->chatTextEdit->verticalScrollBar()->value();
-    int oldMax = ui->chatTextEdit->verticalScrollBar()->maximum();
-
-    QString type = json["type"].toString();
-    QString newMessages;
-    for (const QJsonValue& msgVal : messages)
-    {
-        QJsonObject msg = msgVal.toObject();
-        QString sender = msg["sender"].toString();
-        QString content = msg["content"].toString();
-        QDateTime timestamp = QDateTime::fromString(msg["timestamp"].toString(), Qt::ISODate);
-
-        // Usuwamy sprawdzanie isOwn, wszystkie wiadomości będą po lewej
-        QString timeStr = timestamp.toString("HH:mm:ss");
-        QString messageHtml = QString("<div style='text-align: left;'><b>%1</b> [%2]<br>%3</div>")
-                                  .arg(sender)
-                                  .arg(timeStr)
-                                  .arg(content);
-
-        // If it's a MORE_HISTORY_RESPONSE, prepend older messages
-        if (type == Protocol::MessageType::MORE_HISTORY_RESPONSE) {
-            newMessages = messageHtml + newMessages;
-        } else {
-            newMessages += messageHtml;
-        }
+    QList<ChatTranscriptModel::MessageRecord> batch = recordsFromJson(json["messages"].toArray());
+    const bool latest = (type == Protocol::MessageType::Id::LATEST_MESSAGES_RESPONSE);
+    if (latest) {
+        HistoryPageCache::getInstance().storeLatest(friendId, batch, json["has_more"].toBool());
     }
 
-    // Insert the new messages in the correct position
-    QTextCursor cursor(ui->chatTextEdit->document());
-    if (type == Protocol::MessageType::MORE_HISTORY_RESPONSE) {
-        cursor.movePosition(QTextCursor::Start);
-        cursor.insertHtml(newMessages);
-        // If not empty, insert a newline
-        if (!ui->chatTextEdit->toPlainText().isEmpty()) {
-            cursor.movePosition(QTextCursor::Start);
-            cursor.insertText("\n");
-        }
+    if (latest && reconcilePending) {
+        reconcileWithServer(std::move(batch));
     } else {
-        cursor.movePosition(QTextCursor::End);
-        cursor.insertText("\n");
-        cursor.insertHtml(newMessages);
+        transcriptModel->appendMessages(std::move(batch));
+        ui->transcriptView->scrollToBottom();
     }
 
-    currentOffset += messages.size();
+    // Wczytane wiersze to zawsze ciągły fragment kończący się newerOffset od najnowszej
+    currentOffset = newerOffset + transcriptModel->rowCount();
     hasMoreMessages = json["has_more"].toBool();
     isLoadingHistory = false;
+    trimToBudget();
 
-    if (type == Protocol::MessageType::MORE_HISTORY_RESPONSE) {
-        int newMax = ui->chatTextEdit->verticalScrollBar()->maximum();
-        ui->chatTextEdit->verticalScrollBar()->setValue(oldScrollPos + (newMax - oldMax));
-    } else {
-        ui->chatTextEdit->verticalScrollBar()->setValue(
-            ui->chatTextEdit->verticalScrollBar()->maximum());
+    if (latest) {
+        markMessagesAsRead();
     }
+}
 
-    // Mark messages as read if they are the latest messages and window is visible
-    if (type == Protocol::MessageType::LATEST_MESSAGES_RESPONSE && isVisible() && !messagesMarkedAsRead) {
-        QJsonObject readNotification = Protocol::MessageStructure::createMessageRead(friendId);
-        networkManager.sendMessage(readNotification);
-        messagesMarkedAsRead = true;
-        emit messagesRead(friendId);
+void ChatWindow::reconcileWithServer(QList<ChatTranscriptModel::MessageRecord> latest)
+{
+    reconcilePending = false;
+    MessageStore& store = MessageStore::getInstance();
+
+    // Wiadomości odebrane w trakcie oczekiwania są zwykle już na stronie serwera.
+    // Wracają po niej tylko te, których tam nie ma (np. wysłane po jej zbudowaniu).
+    QList<ChatTranscriptModel::MessageRecord> arrived;
+    for (int row = cachedRows; row < transcriptModel->rowCount(); ++row) {
+        if (findOverlap(latest, transcriptModel->recordAt(row)) < 0) {
+            arrived.append(transcriptModel->recordAt(row));
+        }
+    }
+    for (quint64 key : transcriptModel->evictBack(transcriptModel->rowCount() - cachedRows)) {
+        transcriptDelegate->forget(key);
     }
+    latest.append(arrived);
+
+    // Szukamy ostatniej wiadomości z dysku na stronie serwera - dopisujemy tylko nowsze
+    const qsizetype overlap = cachedRows > 0 ? findOverlap(latest, transcriptModel->recordAt(cachedRows - 1)) : -1;
+
+    if (cachedRows == 0) {
+        // Rozmowy nie było jeszcze na dysku
+        store.append(friendId, toStored(latest));
+        transcriptModel->appendMessages(std::move(latest));
+    } else if (overlap >= 0) {
+        latest.remove(0, overlap + 1);
+        store.append(friendId, toStored(latest));
+        transcriptModel->appendMessages(std::move(latest));
+    } else {
+        // Luka lub rozbieżność z serwerem - strona z serwera zastępuje cache
+        LOG_INFO(QString("Local history of chat %1 is out of date, replacing it").arg(friendId));
+        clearTranscript();
+        store.reset(friendId, toStored(latest));
+        transcriptModel->appendMessages(std::move(latest));
+    }
+    ui->transcriptView->scrollToBottom();
 }
 
 void ChatWindow::handleMessageResponse(const QJsonObject& json)
@@ -189,32 +292,161 @@ void ChatWindow::handleNewMessages(const QJsonObject& json)
     if (fromId == friendId) {
         LOG_INFO("Message is from friend, adding to chat");
         addMessageToChat(friendName, content, timestamp, false, true);
-
-        // If window is visible, send read notification
-        if (isVisible()) {
-            if (!messagesMarkedAsRead) {
-                QJsonObject readNotification = Protocol::MessageStructure::createMessageRead(friendId);
-                networkManager.sendMessage(readNotification);
-                messagesMarkedAsRead = true;
-                emit messagesRead(friendId);
-            }
-        } else {
-            messagesMarkedAsRead = false;
-        }
+        markMessagesAsRead();
     } else {
         LOG_INFO(QString("Message from %1 doesn't match friend ID %2").arg(fromId).arg(friendId));
     }
 }
 
+void ChatWindow::requestHistory(const QJsonObject& request, Protocol::MessageType::Id responseType,
+                                PendingRequests::ResponseCallback onResponse)
+{
+    networkManager.sendRequest(request, responseType, this, std::move(onResponse),
+                               [this]() { onHistoryRequestFailed(); });
+    isLoadingHistory = true;
+}
+
+void ChatWindow::onHistoryRequestFailed()
+{
+    // Bez odpowiedzi okno nie może zostać na stałe w trybie wczytywania
+    LOG_WARNING(QString("History request for chat %1 failed").arg(friendId));
+    isLoadingHistory = false;
+
+    if (reconcilePending) {
+        // Zostają wiersze z dysku. Wiadomości odebrane od teraz nie trafiają do magazynu,
+        // bo między nim a nimi może być luka - uzupełni ją uzgodnienie przy kolejnym otwarciu.
+        reconcilePending = false;
+        storeDetached = true;
+    }
+}
+
+void ChatWindow::prependOlderMessages(QList<ChatTranscriptModel::MessageRecord> batch)
+{
+    // Zachowujemy pozycję: pierwszy widoczny wiersz zostaje na górze
+    const QModelIndex firstVisible = ui->transcriptView->indexAt(QPoint(0, 0));
+    const int added = batch.size();
+    transcriptModel->prependMessages(std::move(batch));
+    if (firstVisible.isValid()) {
+        adjustingScroll = true;
+        ui->transcriptView->scrollTo(transcriptModel->index(firstVisible.row() + added),
+                                     QAbstractItemView::PositionAtTop);
+        adjustingScroll = false;
+    }
+}
+
+int ChatWindow::historyPageSize() const
+{
+    HistoryPageSizer::Inputs inputs;
+    // Przed pierwszym pokazaniem widok nie jest jeszcze ułożony - górna granica to wysokość okna
+    inputs.viewportHeight = isVisible() ? ui->transcriptView->viewport()->height() : height();
+    inputs.rowHeight = transcriptDelegate->averageHeight(ui->transcriptView->font());
+    // Rekord w pamięci (UTF-16) jest bliski rozmiarowi wiadomości w JSON z kluczami i czasem
+    const int rows = transcriptModel->rowCount();
+    inputs.messageBytes = rows > 0 ? static_cast<int>(transcriptModel->memoryUsage() / rows) : 0;
+
+    // Obie odpowiedzi z historią kosztują serwer i łącze tak samo
+    PendingRequests& requests = networkManager.requests();
+    inputs.link = requests.transfer(Protocol::MessageType::Id::GET_MORE_HISTORY);
+    if (inputs.link.bytesPerMs <= 0.0) {
+        inputs.link = requests.transfer(Protocol::MessageType::Id::GET_LATEST_MESSAGES);
+    }
+
+    // Jedna strona nie może od razu przekroczyć budżetu pamięci okna
+    inputs.ceiling = chatConfig.historyPageCeiling;
+    if (chatConfig.maxMessagesPerWindow > 0) {
+        const int budget = qMax(1, chatConfig.maxMessagesPerWindow / 2);
+        inputs.ceiling = inputs.ceiling > 0 ? qMin(inputs.ceiling, budget) : budget;
+    }
+    return HistoryPageSizer::pageSize(inputs);
+}
+
 void ChatWindow::loadInitialHistory()
 {
+    const int pageSize = historyPageSize();
+
+    // Rozmowa śledzona od ostatniego pobrania - bez zapytania do serwera
+    if (std::optional<HistoryPageCache::Page> page = HistoryPageCache::getInstance().latest(friendId, pageSize)) {
+        transcriptModel->appendMessages(std::move(page->records));
+        ui->transcriptView->scrollToBottom();
+        currentOffset = newerOffset + transcriptModel->rowCount();
+        hasMoreMessages = page->hasMore;
+        return;
+    }
+
+    MessageStore& store = MessageStore::getInstance();
+    if (chatConfig.localHistory && store.isOpen()) {
+        // Historia z dysku od razu - serwer uzupełnia tylko nowsze wiadomości
+        QList<ChatTranscriptModel::MessageRecord> cached;
+        for (const MessageStore::StoredMessage& message
+             : store.readLatest(friendId, pageSize)) {
+            cached.append(fromStored(message));
+        }
+        if (!cached.isEmpty()) {
+            cachedRows = cached.size();
+            transcriptModel->appendMessages(std::move(cached));
+            ui->transcriptView->scrollToBottom();
+        }
+    }
+
+    // Wiadomości z czasu oczekiwania nie trafiają do magazynu przed stroną z serwera,
+    // która zwykle już je zawiera - także gdy na dysku nic jeszcze nie było
+    reconcilePending = true;
+
     QJsonObject request;
     request["type"] = Protocol::MessageType::GET_LATEST_MESSAGES;
     request["friend_id"] = friendId;
-    request["limit"] = Protocol::ChatHistory::MESSAGE_BATCH_SIZE;
+    request["limit"] = pageSize;
 
-    networkManager.sendMessage(request);
-    isLoadingHistory = true;
+    requestHistory(request, Protocol::MessageType::Id::LATEST_MESSAGES_RESPONSE, [this](const QJsonObject& json) {
+        handleHistoryResponse(Protocol::MessageType::Id::LATEST_MESSAGES_RESPONSE, json);
+    });
+}
+
+QJsonObject ChatWindow::olderHistoryRequest(const std::optional<ChatTranscriptModel::MessageRecord>& before) const
+{
+    // Offset tylko dla serwerów bez kursora - nowe wiadomości go przesuwają
+    const int offset = currentOffset + prefetcher.bufferedMessages();
+    return Protocol::MessageStructure::createGetMoreHistory(
+        friendId, offset, historyPageSize(),
+        before ? before->timestamp : 0, before ? before->messageId : 0);
+}
+
+HistoryPageCache::Page ChatWindow::olderPageFromJson(const std::optional<ChatTranscriptModel::MessageRecord>& before,
+                                                     const QJsonObject& json)
+{
+    QList<ChatTranscriptModel::MessageRecord> batch = recordsFromJson(json["messages"].toArray());
+    // Starsza historia przychodzi od najnowszej wiadomości
+    std::reverse(batch.begin(), batch.end());
+
+    if (before) {
+        // Serwer bez kursora (przesunięty offset) zwraca też wczytane już wiadomości
+        for (qsizetype i = batch.size() - 1; i >= 0; --i) {
+            if (HistoryPageCache::sameMessage(batch[i], *before)) {
+                batch.remove(i, batch.size() - i);
+                break;
+            }
+        }
+    }
+
+    HistoryPageCache::Page page{std::move(batch), json["has_more"].toBool()};
+    if (before) {
+        HistoryPageCache::getInstance().storeOlder(friendId, *before, page);
+    }
+    return page;
+}
+
+void ChatWindow::onOlderHistory(const std::optional<ChatTranscriptModel::MessageRecord>& before,
+                                const QJsonObject& json)
+{
+    isLoadingHistory = false;
+    HistoryPageCache::Page page = olderPageFromJson(before, json);
+
+    if (before && (transcriptModel->rowCount() == 0
+                   || !HistoryPageCache::sameMessage(transcriptModel->recordAt(0), *before))) {
+        // Początek listy zmienił się w trakcie oczekiwania - strona zostaje tylko w cache
+        return;
+    }
+    showOlderPage(std::move(page));
 }
 
 void ChatWindow::loadMoreHistory()
@@ -222,21 +454,300 @@ void ChatWindow::loadMoreHistory()
     if (!hasMoreMessages || isLoadingHistory)
         return;
 
+    // Strona pobrana z wyprzedzeniem - bez czekania na serwer
+    if (std::optional<HistoryPrefetcher::Page> page = prefetcher.takePage()) {
+        prefetcher.recordHit();
+        showOlderPage(std::move(*page));
+        return;
+    }
+
+    std::optional<ChatTranscriptModel::MessageRecord> before;
+    if (transcriptModel->rowCount() > 0) {
+        before = transcriptModel->recordAt(0);
+        // Zakres już raz pobrany - z cache rozmowy
+        if (std::optional<HistoryPageCache::Page> page = HistoryPageCache::getInstance().olderThan(
+                friendId, *before, historyPageSize())) {
+            prefetcher.recordHit();
+            showOlderPage(std::move(*page));
+            return;
+        }
+    }
+
+    prefetcher.recordMiss();
+    if (prefetcher.inFlight()) {
+        // Strona jest już w drodze - zostanie wyświetlona po nadejściu
+        awaitingPrefetch = true;
+        isLoadingHistory = true;
+        return;
+    }
+
+    requestHistory(olderHistoryRequest(before), Protocol::MessageType::Id::MORE_HISTORY_RESPONSE,
+                   [this, before](const QJsonObject& json) { onOlderHistory(before, json); });
+}
+
+void ChatWindow::maybePrefetchHistory()
+{
+    if (!hasMoreMessages || isLoadingHistory || reconcilePending
+        || prefetcher.inFlight() || prefetcher.exhausted())
+        return;
+
+    const PendingRequests::LatencyStats roundTrip =
+        networkManager.requests().latency(Protocol::MessageType::Id::GET_MORE_HISTORY);
+    const qint64 roundTripMs = roundTrip.samples > 0 ? roundTrip.p90 : HistoryPrefetcher::DEFAULT_ROUND_TRIP_MS;
+    const int distanceToTop = ui->transcriptView->verticalScrollBar()->value();
+
+    if (prefetcher.bufferedPages() < prefetcher.wantedPages(distanceToTop, roundTripMs)) {
+        prefetchOlderHistory();
+    }
+}
+
+std::optional<ChatTranscriptModel::MessageRecord> ChatWindow::olderCursor() const
+{
+    // Strona starsza od wczytanych wierszy i od stron już czekających w buforze
+    if (const ChatTranscriptModel::MessageRecord* oldest = prefetcher.oldestBuffered()) {
+        return *oldest;
+    }
+    if (transcriptModel->rowCount() > 0) {
+        return transcriptModel->recordAt(0);
+    }
+    return std::nullopt;
+}
+
+void ChatWindow::prefetchOlderHistory()
+{
+    const std::optional<ChatTranscriptModel::MessageRecord> before = olderCursor();
+    if (before) {
+        if (std::optional<HistoryPageCache::Page> page = HistoryPageCache::getInstance().olderThan(
+                friendId, *before, historyPageSize())) {
+            prefetcher.storePage(std::move(*page));
+            return;
+        }
+    }
+
+    prefetcher.setInFlight(networkManager.sendRequest(
+        olderHistoryRequest(before), Protocol::MessageType::Id::MORE_HISTORY_RESPONSE, this,
+        [this, before](const QJsonObject& json) { onPrefetchedHistory(before, json); },
+        [this]() { onPrefetchFailed(); }));
+}
+
+void ChatWindow::onPrefetchedHistory(const std::optional<ChatTranscriptModel::MessageRecord>& before,
+                                     const QJsonObject& json)
+{
+    prefetcher.clearInFlight();
+
+    HistoryPageCache::Page page = olderPageFromJson(before, json);
+    const std::optional<ChatTranscriptModel::MessageRecord> expected = olderCursor();
+    if (before && (!expected || !HistoryPageCache::sameMessage(*expected, *before))) {
+        // Strona nie przylega już do bufora - zostaje tylko w cache
+        onPrefetchFailed();
+        return;
+    }
+    prefetcher.storePage(std::move(page));
+
+    if (awaitingPrefetch) {
+        awaitingPrefetch = false;
+        isLoadingHistory = false;
+        showOlderPage(*prefetcher.takePage());
+    } else {
+        maybePrefetchHistory();
+    }
+}
+
+void ChatWindow::onPrefetchFailed()
+{
+    prefetcher.clearInFlight();
+    if (awaitingPrefetch) {
+        awaitingPrefetch = false;
+        isLoadingHistory = false;
+    }
+}
+
+void ChatWindow::showOlderPage(HistoryPageCache::Page page)
+{
+    prependOlderMessages(std::move(page.records));
+    currentOffset = newerOffset + transcriptModel->rowCount();
+    hasMoreMessages = page.hasMore;
+    trimToBudget();
+    maybePrefetchHistory();
+}
+
+void ChatWindow::cancelPrefetch()
+{
+    if (const quint64 requestId = prefetcher.inFlight()) {
+        networkManager.requests().cancelRequest(requestId);
+        prefetcher.clearInFlight();
+    }
+    if (awaitingPrefetch) {
+        awaitingPrefetch = false;
+        isLoadingHistory = false;
+    }
+}
+
+void ChatWindow::loadNewerHistory()
+{
+    if (newerOffset <= 0 || isLoadingHistory)
+        return;
+
+    // Usunięte z końca wiadomości były już wczytane - zwykle są w cache rozmowy
+    const int pageSize = historyPageSize();
+    if (transcriptModel->rowCount() > 0) {
+        const ChatTranscriptModel::MessageRecord& newest = transcriptModel->recordAt(transcriptModel->rowCount() - 1);
+        if (std::optional<HistoryPageCache::Page> page
+            = HistoryPageCache::getInstance().newerThan(friendId, newest, pageSize)) {
+            appendNewerMessages(std::move(page->records), !page->hasMore);
+            return;
+        }
+    }
+
+    // Strona kończąca się tuż przed najnowszą wczytaną wiadomością
+    pendingOffset = qMax(0, newerOffset - pageSize);
+
     QJsonObject request;
     request["type"] = Protocol::MessageType::GET_MORE_HISTORY;
     request["friend_id"] = friendId;
-    request["offset"] = currentOffset;
+    request["offset"] = pendingOffset;
+    request["limit"] = pageSize;
 
-    networkManager.sendMessage(request);
-    isLoadingHistory = true;
+    requestHistory(request, Protocol::MessageType::Id::MORE_HISTORY_RESPONSE,
+                   [this](const QJsonObject& json) { onNewerHistory(json); });
+}
+
+void ChatWindow::onNewerHistory(const QJsonObject& json)
+{
+    isLoadingHistory = false;
+
+    // Ponowne pobranie usuniętych nowszych wiadomości - odpowiedź od najnowszej
+    QList<ChatTranscriptModel::MessageRecord> batch = recordsFromJson(json["messages"].toArray());
+    std::reverse(batch.begin(), batch.end());
+    // Przy offsecie przyciętym do zera strona obejmuje też wczytane już wiadomości
+    const int wanted = newerOffset - pendingOffset;
+    if (batch.size() > wanted) {
+        batch.remove(0, batch.size() - wanted);
+    }
+
+    // Pusta odpowiedź - serwer nie ma nowszych wiadomości
+    const bool reachedLatest = batch.isEmpty();
+    appendNewerMessages(std::move(batch), reachedLatest);
+}
+
+void ChatWindow::appendNewerMessages(QList<ChatTranscriptModel::MessageRecord> batch, bool reachedLatest)
+{
+    newerOffset -= batch.size();
+    transcriptModel->appendMessages(std::move(batch));
+    if (reachedLatest || newerOffset < 0) {
+        currentOffset -= newerOffset;
+        newerOffset = 0;
+    }
+    trimToBudget();
+}
+
+void ChatWindow::returnToLatest()
+{
+    clearTranscript();
+    currentOffset = 0;
+    newerOffset = 0;
+    hasMoreMessages = true;
+    loadInitialHistory();
+}
+
+bool ChatWindow::overBudget(int count, qint64 bytes) const
+{
+    return (chatConfig.maxMessagesPerWindow > 0 && count > chatConfig.maxMessagesPerWindow)
+           || (chatConfig.maxBytesPerWindow > 0 && bytes > chatConfig.maxBytesPerWindow);
+}
+
+void ChatWindow::trimToBudget()
+{
+    const int rows = transcriptModel->rowCount();
+    if (reconcilePending || !overBudget(rows, transcriptModel->memoryUsage()))
+        return;
+
+    QListView* view = ui->transcriptView;
+    QScrollBar* scrollBar = view->verticalScrollBar();
+    const QModelIndex top = view->indexAt(QPoint(0, 0));
+    const QModelIndex bottom = view->indexAt(QPoint(0, view->viewport()->height() - 1));
+    const bool followBottom = newerOffset == 0
+                              && (!top.isValid() || scrollBar->value() >= scrollBar->maximum());
+
+    // Wiersze w pobliżu widoku zostają, usuwamy z końca dalszego od widoku
+    const int margin = Protocol::ChatHistory::MESSAGE_BATCH_SIZE;
+    const int firstVisible = (top.isValid() && !followBottom) ? top.row() : rows - 1;
+    const int lastVisible = (bottom.isValid() && !followBottom) ? bottom.row() : rows - 1;
+    const int evictableFront = qMax(0, firstVisible - margin);
+    const int evictableBack = qMax(0, rows - 1 - lastVisible - margin);
+
+    int front = 0;
+    int back = 0;
+    int count = rows;
+    qint64 bytes = transcriptModel->memoryUsage();
+    while (overBudget(count, bytes) && (front < evictableFront || back < evictableBack)) {
+        if (evictableFront - front >= evictableBack - back) {
+            bytes -= ChatTranscriptModel::recordSize(transcriptModel->recordAt(front));
+            ++front;
+        } else {
+            bytes -= ChatTranscriptModel::recordSize(transcriptModel->recordAt(rows - 1 - back));
+            ++back;
+        }
+        --count;
+    }
+
+    if (back > 0) {
+        for (quint64 key : transcriptModel->evictBack(back)) {
+            transcriptDelegate->forget(key);
+        }
+        newerOffset += back;
+    }
+
+    if (front > 0) {
+        for (quint64 key : transcriptModel->evictFront(front)) {
+            transcriptDelegate->forget(key);
+        }
+        currentOffset -= front;
+        hasMoreMessages = true;
+        // Strony z wyprzedzeniem nie przylegają już do wczytanych wierszy
+        cancelPrefetch();
+        prefetcher.clearPages();
+
+        adjustingScroll = true;
+        if (followBottom) {
+            view->scrollToBottom();
+        } else if (top.isValid()) {
+            view->scrollTo(transcriptModel->index(top.row() - front), QAbstractItemView::PositionAtTop);
+        }
+        adjustingScroll = false;
+    }
+
+    evictedTotal += front + back;
+    LOG_DEBUG(QString("Chat %1: evicted %2 older and %3 newer messages, %4 messages / %5 bytes in memory")
+                  .arg(friendId).arg(front).arg(back).arg(messageCount()).arg(memoryUsage()));
+}
+
+qint64 ChatWindow::memoryUsage() const
+{
+    // Wpis cache wysokości: klucz + wysokość
+    const qint64 layoutEntry = static_cast<qint64>(sizeof(quint64) + sizeof(int));
+    return transcriptModel->memoryUsage() + transcriptDelegate->cachedLayouts() * layoutEntry;
 }
 
 void ChatWindow::onScrollValueChanged(int value)
 {
-    QScrollBar* scrollBar = ui->chatTextEdit->verticalScrollBar();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (adjustingScroll) {
+        prefetcher.rebase(value, now);
+        return;
+    }
+    if (prefetcher.onScroll(value, now)) {
+        // Użytkownik zawrócił w dół - strona w drodze nie będzie potrzebna
+        cancelPrefetch();
+    }
+
+    QScrollBar* scrollBar = ui->transcriptView->verticalScrollBar();
     if (value <= scrollBar->maximum() * 0.1) {
         loadMoreHistory();
+    } else if (newerOffset > 0 && value >= scrollBar->maximum() * 0.9) {
+        loadNewerHistory();
     }
+    maybePrefetchHistory();
 }
 
 void ChatWindow::onSendMessageClicked()
@@ -250,48 +761,99 @@ void ChatWindow::onSendMessageClicked()
     QString sender = networkManager.getUsername();
     bool isOwn = (sender != friendName);
 
-    addMessageToChat(sender, message, currentTime, isOwn, true);
     networkManager.sendMessage(messageRequest);
+    addMessageToChat(sender, message, currentTime, isOwn, true);
+    if (newerOffset > 0) {
+        // Koniec historii usunięty z pamięci - wracamy do najnowszych wiadomości
+        returnToLatest();
+    }
     ui->messageLineEdit->clear();
 }
 
 void ChatWindow::addMessageToChat(const QString& sender, const QString& content,
                                   const QDateTime& timestamp, bool isOwn, bool atEnd)
 {
-    QString timeStr = timestamp.toString("HH:mm:ss");
+    ChatTranscriptModel::MessageRecord record;
+    record.sender = sender;
+    record.content = content;
+    record.timestamp = timestamp.toMSecsSinceEpoch();
+    record.isOwn = isOwn;
+    if (!isOwn) {
+        lastIncomingTimestamp = qMax(lastIncomingTimestamp, record.timestamp);
+    }
+    if (!reconcilePending && !storeDetached) {
+        // W trakcie uzgadniania z serwerem wiadomość trafi do magazynu ze strony serwera
+        MessageStore::getInstance().append(friendId, {toStored(record)});
+    }
+    HistoryPageCache::getInstance().append(friendId, record);
 
-    // Usuwamy sprawdzanie isOwn, wszystkie wiadomości będą po lewej
-    QString messageHtml = QString("\n<div style='text-align: left;'><b>%1</b> [%2]<br>%3</div>")
-                              .arg(sender)
-                              .arg(timeStr)
-                              .arg(content);
+    // Każda nowa wiadomość przesuwa offsety historii na serwerze
+    ++currentOffset;
+    if (newerOffset > 0) {
+        // Użytkownik przegląda starszą historię - wiadomość zostanie pobrana przy powrocie
+        ++newerOffset;
+        return;
+    }
 
-    QTextCursor cursor(ui->chatTextEdit->document());
-    cursor.movePosition(QTextCursor::End);
-    cursor.insertText("\n");
-    cursor.insertHtml(messageHtml);
+    transcriptModel->appendMessage(std::move(record));
 
     if (atEnd) {
-        ui->chatTextEdit->verticalScrollBar()->setValue(
-            ui->chatTextEdit->verticalScrollBar()->maximum());
+        ui->transcriptView->scrollToBottom();
     }
+    trimToBudget();
 }
 
-void ChatWindow::processMessage(const QJsonObject& message)
+void ChatWindow::processMessage(Protocol::MessageType::Id type, const QJsonObject& message)
 {
-    onMessageReceived(message);
+    switch (type) {
+    case Protocol::MessageType::Id::MESSAGE_RESPONSE:
+        handleMessageResponse(message);
+        break;
+    case Protocol::MessageType::Id::NEW_MESSAGES:
+        handleNewMessages(message);
+        break;
+    default:
+        LOG_INFO(QString("ChatWindow::processMessage - Unhandled message type: %1")
+                     .arg(Protocol::MessageType::toString(type)));
+        break;
+    }
 }
 
 void ChatWindow::showEvent(QShowEvent* event)
 {
     QWidget::showEvent(event);
+    markMessagesAsRead();
+}
 
-    if (!messagesMarkedAsRead) {
-        QJsonObject readNotification = Protocol::MessageStructure::createMessageRead(friendId);
-        networkManager.sendMessage(readNotification);
+void ChatWindow::markMessagesAsRead()
+{
+    if (friendId == NO_FRIEND || !isVisible()) return;
+
+    // Najnowsza wiadomość rozmówcy: z końca listy albo odebrana przy usuniętym końcu historii
+    qint64 newest = lastIncomingTimestamp;
+    qint64 newestId = 0;
+    for (int row = transcriptModel->rowCount() - 1; row >= 0; --row) {
+        const ChatTranscriptModel::MessageRecord& record = transcriptModel->recordAt(row);
+        if (!record.isOwn) {
+            if (record.timestamp >= newest) {
+                newest = record.timestamp;
+                newestId = record.messageId;
+            }
+            break;
+        }
+    }
 
-        LOG_INFO(QString("Sent read notification for messages from friend ID: %1").arg(friendId));
-        messagesMarkedAsRead = true;
+    // Zgłoszenia z kilku miejsc (pokazanie okna, historia, nowa wiadomość) łączy agregator
+    if (networkManager.readReceipts().markRead(friendId, newest, newestId)) {
+        LOG_DEBUG(QString("Messages from friend ID %1 read up to %2").arg(friendId).arg(newest));
         emit messagesRead(friendId);
     }
 }
+
+void ChatWindow::closeEvent(QCloseEvent* event)
+{
+    QWidget::closeEvent(event);
+    if (event->isAccepted()) {
+        emit closed(friendId);
+    }
+}
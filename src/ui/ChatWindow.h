@@ -6,9 +6,14 @@
 #include <QDateTime>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <functional>
-#include <unordered_map>
 #include "network/NetworkManager.h"
+#include "config/ConfigManager.h"
+#include "ChatTranscriptModel.h"
+#include "ChatMessageDelegate.h"
+#include "HistoryPrefetcher.h"
+#include "HistoryPageCache.h"
+#include "HistoryPageSizer.h"
+#include <optional>
 
 namespace Ui {
 class ChatWindow;
@@ -18,37 +23,55 @@ class ChatWindow : public QWidget {
     Q_OBJECT
 
 public:
-    explicit ChatWindow(const QString& friendName, int friendId, QWidget *parent = nullptr);
+    static constexpr int NO_FRIEND = -1;
+
+    // Okno bez rozmówcy (pula okien) - przypisywane przez bind()
+    explicit ChatWindow(QWidget *parent = nullptr);
+    ChatWindow(const QString& friendName, int friendId, QWidget *parent = nullptr);
     ~ChatWindow();
 
-    void processMessage(const QJsonObject& message);
+    // Przypisanie do rozmówcy: tytuł, subskrypcje routera, wczytanie historii
+    void bind(const QString& friendName, int friendId);
+    // Odpięcie od rozmówcy - okno wraca do stanu z konstruktora
+    void reset();
+    int boundFriendId() const { return friendId; }
+
+    void processMessage(Protocol::MessageType::Id type, const QJsonObject& message);
+
+    // Pamięć zajmowana przez historię tego okna (rekordy + cache wysokości)
+    qint64 memoryUsage() const;
+    int messageCount() const { return transcriptModel->rowCount(); }
+    int evictedCount() const { return evictedTotal; }
+    // Dojście do góry listy: strona już pobrana z wyprzedzeniem / trzeba czekać na serwer
+    quint64 prefetchHits() const { return prefetcher.hits(); }
+    quint64 prefetchMisses() const { return prefetcher.misses(); }
 
 private slots:
     void onSendMessageClicked();
-    void onMessageReceived(const QJsonObject& message);
     void onScrollValueChanged(int value);
     void loadMoreHistory();
+    void loadNewerHistory();
 
 signals:
     void messagesRead(int friendId);
+    void closed(int friendId);
 
 private:
     // UI initialization
     void initializeUI();
 
-    // Message handling refactored
+    // Message handling
     void setupMessageHandlers();
-    void dispatchMessage(const QJsonObject& json);
 
     // Handlers for specific message types
-    void handleHistoryResponse(const QJsonObject& json);
+    void handleHistoryResponse(Protocol::MessageType::Id type, const QJsonObject& json);
     void handleMessageResponse(const QJsonObject& json);
+    void reconcileWithServer(QList<ChatTranscriptModel::MessageRecord> latest);
     void handleNewMessages(const QJsonObject& json);
 
+    QList<ChatTranscriptModel::MessageRecord> recordsFromJson(const QJsonArray& messages) const;
+
     // Message display
-    QString createMessageHtml(const QString& sender, const QString& content,
-                              const QDateTime& timestamp, bool isOwn);
-    void insertMessageToChat(const QString& messageHtml, bool atBeginning);
     void addMessageToChat(const QString& sender, const QString& content,
                           const QDateTime& timestamp, bool isOwn, bool atEnd = true);
 
@@ -57,24 +80,68 @@ private:
     bool shouldLoadMoreHistory(int scrollValue) const;
 
     // History management
+    void requestHistory(const QJsonObject& request, Protocol::MessageType::Id responseType,
+                        PendingRequests::ResponseCallback onResponse);
+    void onHistoryRequestFailed();
+    // Liczba wiadomości w jednej stronie historii: widok, wysokość wierszy, pomiary łącza
+    int historyPageSize() const;
     void loadInitialHistory();
+    // Strony historii wyznaczane kursorem: najstarszą / najnowszą wczytaną wiadomością
+    QJsonObject olderHistoryRequest(const std::optional<ChatTranscriptModel::MessageRecord>& before) const;
+    HistoryPageCache::Page olderPageFromJson(const std::optional<ChatTranscriptModel::MessageRecord>& before,
+                                             const QJsonObject& json);
+    void onOlderHistory(const std::optional<ChatTranscriptModel::MessageRecord>& before, const QJsonObject& json);
+    void onNewerHistory(const QJsonObject& json);
+    void showOlderPage(HistoryPageCache::Page page);
+    void appendNewerMessages(QList<ChatTranscriptModel::MessageRecord> batch, bool reachedLatest);
+    void prependOlderMessages(QList<ChatTranscriptModel::MessageRecord> batch);
+    void returnToLatest();
+    void clearTranscript();
     void markMessagesAsRead();
 
+    // Prefetch of older history
+    void maybePrefetchHistory();
+    std::optional<ChatTranscriptModel::MessageRecord> olderCursor() const;
+    void prefetchOlderHistory();
+    void onPrefetchedHistory(const std::optional<ChatTranscriptModel::MessageRecord>& before,
+                             const QJsonObject& json);
+    void onPrefetchFailed();
+    void cancelPrefetch();
+
+    // Memory budget
+    bool overBudget(int count, qint64 bytes) const;
+    void trimToBudget();
+
     // UI components
     Ui::ChatWindow *ui;
     NetworkManager& networkManager;
+    ChatTranscriptModel* transcriptModel;
+    ChatMessageDelegate* transcriptDelegate;
 
     // Chat properties
     QString friendName;
     int friendId;
-    int currentOffset;
+    int currentOffset;      // Odległość najstarszej wczytanej wiadomości od najnowszej
+    int newerOffset;        // Najnowsze wiadomości usunięte z końca historii
     bool hasMoreMessages;
     bool isLoadingHistory;
-    bool messagesMarkedAsRead;
+    qint64 lastIncomingTimestamp;   // Najnowsza wiadomość rozmówcy odebrana w tym oknie
+
+    int pendingOffset;
+
+    ConfigManager::ChatConfig chatConfig;
+    int evictedTotal;
+
+    // Historia z lokalnego magazynu czeka na porównanie z serwerem
+    bool reconcilePending;
+    int cachedRows;
+    bool storeDetached;         // Uzgadnianie się nie udało - magazyn czeka na kolejne otwarcie rozmowy
 
-    // Dispatch map for message handling
-    std::unordered_map<QString, std::function<void(const QJsonObject&)>> messageHandlers;
+    HistoryPrefetcher prefetcher;
+    bool awaitingPrefetch;      // Użytkownik na górze listy czeka na stronę w drodze
+    bool adjustingScroll;       // Zmiana pozycji paska przez program, nie przez użytkownika
 
 protected:
     void showEvent(QShowEvent* event) override;
+    void closeEvent(QCloseEvent* event) override;
 };
@@ -0,0 +1,67 @@
+/**
+ * @file ChatWindowPool.cpp
+ * @brief Pool of reusable chat windows implementation
+ * @author piotrek-pl
+ * @date 2025-02-09 18:12:44
+ */
+
+#include "ChatWindowPool.h"
+
+ChatWindowPool::ChatWindowPool(int capacity, QObject* parent)
+    : QObject(parent)
+    , capacity(qMax(0, capacity))
+    , created(0)
+    , reused(0)
+{
+}
+
+ChatWindowPool::~ChatWindowPool()
+{
+    qDeleteAll(idle);
+}
+
+ChatWindow* ChatWindowPool::create()
+{
+    ChatWindow* window = new ChatWindow();
+    // Styl rozwiązywany teraz, a nie przy pierwszym show()
+    window->ensurePolished();
+    for (QWidget* child : window->findChildren<QWidget*>()) {
+        child->ensurePolished();
+    }
+    ++created;
+    return window;
+}
+
+void ChatWindowPool::warmUp()
+{
+    while (idle.size() < capacity) {
+        idle.append(create());
+    }
+}
+
+ChatWindow* ChatWindowPool::acquire(const QString& friendName, int friendId)
+{
+    ChatWindow* window = nullptr;
+    if (idle.isEmpty()) {
+        window = create();
+    } else {
+        window = idle.takeLast();
+        ++reused;
+    }
+    window->bind(friendName, friendId);
+    return window;
+}
+
+void ChatWindowPool::release(ChatWindow* window)
+{
+    if (!window || idle.contains(window)) return;
+
+    window->hide();
+    window->reset();
+    if (idle.size() < capacity) {
+        idle.append(window);
+    } else {
+        // Wywołanie może pochodzić z closeEvent tego okna
+        window->deleteLater();
+    }
+}
@@ -0,0 +1,47 @@
+/**
+ * @file ChatWindowPool.h
+ * @brief Pool of reusable chat windows definition
+ * @author piotrek-pl
+ * @date 2025-02-09 18:12:44
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QList>
+#include "ChatWindow.h"
+
+/**
+ * Keeps hidden, fully built ChatWindow instances so opening a chat only
+ * rebinds an existing widget tree instead of running setupUi. Closed windows
+ * are reset and returned to the pool up to its capacity; the rest are
+ * deleted. Used only from the GUI thread.
+ */
+class ChatWindowPool : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ChatWindowPool(int capacity, QObject* parent = nullptr);
+    ~ChatWindowPool();
+
+    // Okno z puli (lub nowe, gdy pula jest pusta) przypisane do rozmówcy
+    ChatWindow* acquire(const QString& friendName, int friendId);
+    // Okno zamknięte przez użytkownika - czyszczone i odkładane do puli
+    void release(ChatWindow* window);
+
+    int idleCount() const { return idle.size(); }
+    quint64 createdCount() const { return created; }
+    quint64 reusedCount() const { return reused; }
+
+public slots:
+    // Wypełnienie puli w wolnej chwili, np. zaraz po zalogowaniu
+    void warmUp();
+
+private:
+    ChatWindow* create();
+
+    int capacity;
+    QList<ChatWindow*> idle;
+    quint64 created;
+    quint64 reused;
+};
@@ -0,0 +1,325 @@
+/**
+ * @file FriendsModel.cpp
+ * @brief Indexed friends list model implementation
+ * @author piotrek-pl
+ * @date 2025-02-06 16:52:08
+ */
+
+#include "FriendsModel.h"
+#include "StatusIconCache.h"
+#include "network/Protocol.h"
+#include <QBrush>
+#include <QSet>
+#include <algorithm>
+
+FriendsModel::FriendsModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+    bucketSizes.fill(0);
+}
+
+int FriendsModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ids.size();
+}
+
+QVariant FriendsModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= ids.size()) return QVariant();
+
+    const int row = index.row();
+    switch (role) {
+    case Qt::DisplayRole:
+        return names[row];
+    case Qt::DecorationRole:
+        return StatusIconCache::getInstance().icon(statuses[row], unreadFlags[row]);
+    case Qt::ForegroundRole:
+        return QBrush(Qt::black);
+    case FriendIdRole:
+        return ids[row];
+    case StatusRole:
+        return statusToString(statuses[row]);
+    case UnreadRole:
+        return unreadFlags[row];
+    default:
+        return QVariant();
+    }
+}
+
+QVector<FriendsModel::Entry> FriendsModel::parseFriends(const QJsonArray& friends)
+{
+    QVector<Entry> entries;
+    entries.reserve(friends.size());
+    QSet<int> seen;
+    seen.reserve(friends.size());
+    for (qsizetype i = friends.size() - 1; i >= 0; --i) {
+        const QJsonObject friendObj = friends[i].toObject();
+        const int friendId = friendObj["id"].toInt();
+        if (seen.contains(friendId)) continue;
+
+        seen.insert(friendId);
+        entries.append(Entry{friendId,
+                             friendObj["username"].toString(),
+                             parseStatus(friendObj["status"].toString())});
+    }
+    std::reverse(entries.begin(), entries.end());
+    return entries;
+}
+
+void FriendsModel::setFriends(const QJsonArray& friends)
+{
+    const QVector<Entry> entries = parseFriends(friends);
+    beginResetModel();
+
+    ids.clear();
+    names.clear();
+    statuses.clear();
+    unreadFlags.clear();
+    rowById.clear();
+    bucketSizes.fill(0);
+
+    ids.reserve(entries.size());
+    names.reserve(entries.size());
+    statuses.reserve(entries.size());
+    unreadFlags.reserve(entries.size());
+    rowById.reserve(entries.size());
+
+    // Kolejność kubełków statusu, w kubełku kolejność z serwera
+    for (int bucket = 0; bucket < STATUS_COUNT; ++bucket) {
+        for (const Entry& entry : entries) {
+            if (static_cast<int>(entry.status) != bucket) continue;
+
+            appendRow(entry.id, entry.name, entry.status, false);
+        }
+    }
+
+    endResetModel();
+}
+
+void FriendsModel::applySnapshot(const QJsonArray& friends)
+{
+    if (ids.isEmpty()) {
+        setFriends(friends);
+        return;
+    }
+
+    // Powtórzone id zajęłyby dwa miejsca w kubełku przy układaniu kolejności
+    const QVector<Entry> incoming = parseFriends(friends);
+    QSet<int> incomingIds;
+    incomingIds.reserve(incoming.size());
+    for (const Entry& entry : incoming) {
+        incomingIds.insert(entry.id);
+    }
+
+    // Usunięci znajomi
+    for (int row = ids.size() - 1; row >= 0; --row) {
+        if (!incomingIds.contains(ids[row])) {
+            removeFriend(ids[row]);
+        }
+    }
+
+    // Nowi znajomi, zmiany statusu i nazwy
+    for (const Entry& entry : incoming) {
+        const int row = rowOf(entry.id);
+        if (row < 0) {
+            insertFriend(entry.id, entry.name, entry.status);
+            continue;
+        }
+        if (names[row] != entry.name) {
+            setName(row, entry.name);
+        }
+        if (statuses[row] != entry.status) {
+            setStatus(entry.id, statusToString(entry.status));
+        }
+    }
+
+    // Kolejność w kubełkach jak na serwerze - przy niezmienionej liście brak ruchów
+    std::array<int, STATUS_COUNT> nextRow{};
+    for (int bucket = 1; bucket < STATUS_COUNT; ++bucket) {
+        nextRow[bucket] = nextRow[bucket - 1] + bucketSizes[bucket - 1];
+    }
+    for (const Entry& entry : incoming) {
+        const int target = nextRow[static_cast<int>(entry.status)]++;
+        const int row = rowOf(entry.id);
+        if (row != target) {
+            moveRow(row, target);
+        }
+    }
+}
+
+void FriendsModel::applyDelta(const QJsonObject& delta)
+{
+    for (const QJsonValue& removed : delta["removed"].toArray()) {
+        removeFriend(removed.toInt());
+    }
+
+    for (const QJsonValue& addedValue : delta["added"].toArray()) {
+        const QJsonObject added = addedValue.toObject();
+        const int friendId = added["id"].toInt();
+        if (contains(friendId)) {
+            setStatus(friendId, added["status"].toString());
+        } else {
+            insertFriend(friendId, added["username"].toString(),
+                         parseStatus(added["status"].toString()));
+        }
+    }
+
+    for (const QJsonValue& changeValue : delta["changes"].toArray()) {
+        const QJsonObject change = changeValue.toObject();
+        setStatus(change["id"].toInt(), change["status"].toString());
+    }
+}
+
+void FriendsModel::clear()
+{
+    if (ids.isEmpty()) return;
+
+    beginResetModel();
+    ids.clear();
+    names.clear();
+    statuses.clear();
+    unreadFlags.clear();
+    rowById.clear();
+    bucketSizes.fill(0);
+    endResetModel();
+}
+
+QString FriendsModel::nameOf(int friendId) const
+{
+    const int row = rowOf(friendId);
+    return row < 0 ? QString() : names[row];
+}
+
+QString FriendsModel::statusOf(int friendId) const
+{
+    const int row = rowOf(friendId);
+    return row < 0 ? Protocol::UserStatus::OFFLINE : statusToString(statuses[row]);
+}
+
+void FriendsModel::setStatus(int friendId, const QString& statusString)
+{
+    const int row = rowOf(friendId);
+    if (row < 0) return;
+
+    const Status status = parseStatus(statusString);
+    const Status previous = statuses[row];
+    if (status == previous) return;
+
+    // Docelowo koniec nowego kubełka (po usunięciu wiersza ze starego)
+    int target = bucketEnd(status);
+    if (previous < status) --target;
+
+    --bucketSizes[static_cast<int>(previous)];
+    ++bucketSizes[static_cast<int>(status)];
+    statuses[row] = status;
+
+    moveRow(row, target);
+
+    const QModelIndex changed = index(target);
+    emit dataChanged(changed, changed, {Qt::DecorationRole, StatusRole});
+}
+
+void FriendsModel::setUnread(int friendId, bool unread)
+{
+    const int row = rowOf(friendId);
+    if (row < 0 || unreadFlags[row] == unread) return;
+
+    unreadFlags[row] = unread;
+    const QModelIndex changed = index(row);
+    emit dataChanged(changed, changed, {Qt::DecorationRole, UnreadRole});
+}
+
+void FriendsModel::removeFriend(int friendId)
+{
+    const int row = rowOf(friendId);
+    if (row < 0) return;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    --bucketSizes[static_cast<int>(statuses[row])];
+    ids.remove(row);
+    names.remove(row);
+    statuses.remove(row);
+    unreadFlags.remove(row);
+    rowById.remove(friendId);
+    reindex(row, ids.size() - 1);
+    endRemoveRows();
+}
+
+FriendsModel::Status FriendsModel::parseStatus(const QString& status)
+{
+    if (status == Protocol::UserStatus::ONLINE) return Status::Online;
+    if (status == Protocol::UserStatus::AWAY) return Status::Away;
+    if (status == Protocol::UserStatus::BUSY) return Status::Busy;
+    return Status::Offline;
+}
+
+QString FriendsModel::statusToString(Status status)
+{
+    switch (status) {
+    case Status::Online: return Protocol::UserStatus::ONLINE;
+    case Status::Away: return Protocol::UserStatus::AWAY;
+    case Status::Busy: return Protocol::UserStatus::BUSY;
+    default: return Protocol::UserStatus::OFFLINE;
+    }
+}
+
+void FriendsModel::appendRow(int friendId, const QString& name, Status status, bool unread)
+{
+    rowById.insert(friendId, ids.size());
+    ids.append(friendId);
+    names.append(name);
+    statuses.append(status);
+    unreadFlags.append(unread);
+    ++bucketSizes[static_cast<int>(status)];
+}
+
+void FriendsModel::insertFriend(int friendId, const QString& name, Status status)
+{
+    const int row = bucketEnd(status);
+
+    beginInsertRows(QModelIndex(), row, row);
+    ids.insert(row, friendId);
+    names.insert(row, name);
+    statuses.insert(row, status);
+    unreadFlags.insert(row, false);
+    ++bucketSizes[static_cast<int>(status)];
+    reindex(row, ids.size() - 1);
+    endInsertRows();
+}
+
+void FriendsModel::setName(int row, const QString& name)
+{
+    names[row] = name;
+    const QModelIndex changed = index(row);
+    emit dataChanged(changed, changed, {Qt::DisplayRole});
+}
+
+void FriendsModel::moveRow(int from, int to)
+{
+    if (from == to) return;
+
+    // Qt oczekuje pozycji docelowej sprzed usunięcia wiersza
+    beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+    ids.move(from, to);
+    names.move(from, to);
+    statuses.move(from, to);
+    unreadFlags.move(from, to);
+    reindex(qMin(from, to), qMax(from, to));
+    endMoveRows();
+}
+
+void FriendsModel::reindex(int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        rowById[ids[row]] = row;
+    }
+}
+
+int FriendsModel::bucketEnd(Status status) const
+{
+    int end = 0;
+    for (int bucket = 0; bucket <= static_cast<int>(status); ++bucket) {
+        end += bucketSizes[bucket];
+    }
+    return end;
+}
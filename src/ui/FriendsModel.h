@@ -0,0 +1,88 @@
+/**
+ * @file FriendsModel.h
+ * @brief Indexed friends list model definition
+ * @author piotrek-pl
+ * @date 2025-02-06 16:52:08
+ */
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QHash>
+#include <QVector>
+#include <array>
+
+/**
+ * Friends list kept as parallel arrays ordered by status bucket
+ * (online, away, busy, offline), arrival order inside a bucket.
+ * An id -> row index gives O(1) lookups; a status change moves one row
+ * to the end of its new bucket instead of rebuilding the list.
+ */
+class FriendsModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        FriendIdRole = Qt::UserRole,
+        StatusRole = Qt::UserRole + 1,
+        UnreadRole = Qt::UserRole + 2
+    };
+
+    enum class Status : quint8 {
+        Online,
+        Away,
+        Busy,
+        Offline
+    };
+    static constexpr int STATUS_COUNT = 4;
+
+    explicit FriendsModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    void setFriends(const QJsonArray& friends);
+    // Porównuje pełną listę z bieżącym stanem i stosuje tylko różnice
+    void applySnapshot(const QJsonArray& friends);
+    void applyDelta(const QJsonObject& delta);
+    void clear();
+
+    bool contains(int friendId) const { return rowById.contains(friendId); }
+    int rowOf(int friendId) const { return rowById.value(friendId, -1); }
+    int friendIdAt(int row) const { return ids.value(row, -1); }
+    QString nameOf(int friendId) const;
+    QString statusOf(int friendId) const;
+
+    void setStatus(int friendId, const QString& status);
+    void setUnread(int friendId, bool unread);
+    void removeFriend(int friendId);
+
+    static Status parseStatus(const QString& status);
+    static QString statusToString(Status status);
+
+private:
+    struct Entry {
+        int id;
+        QString name;
+        Status status;
+    };
+    // Lista z serwera bez powtórzeń id - wygrywa ostatni wpis
+    static QVector<Entry> parseFriends(const QJsonArray& friends);
+
+    void appendRow(int friendId, const QString& name, Status status, bool unread);
+    void insertFriend(int friendId, const QString& name, Status status);
+    void setName(int row, const QString& name);
+    void moveRow(int from, int to);
+    void reindex(int first, int last);
+    int bucketEnd(Status status) const;
+
+    // Struct-of-arrays: wiersz i opisują ids[i], names[i], statuses[i], unread[i]
+    QVector<int> ids;
+    QVector<QString> names;
+    QVector<Status> statuses;
+    QVector<bool> unreadFlags;
+    QHash<int, int> rowById;
+    std::array<int, STATUS_COUNT> bucketSizes;
+};
@@ -0,0 +1,192 @@
+/**
+ * @file HistoryPageCache.cpp
+ * @brief Per-conversation cache of chat history pages implementation
+ * @author piotrek-pl
+ * @date 2025-02-10 15:42:18
+ */
+
+#include "HistoryPageCache.h"
+
+HistoryPageCache::HistoryPageCache()
+    : hitCount(0)
+    , missCount(0)
+{
+}
+
+HistoryPageCache& HistoryPageCache::getInstance()
+{
+    static HistoryPageCache instance;
+    return instance;
+}
+
+bool HistoryPageCache::sameMessage(const MessageRecord& a, const MessageRecord& b)
+{
+    if (a.messageId != 0 && b.messageId != 0) {
+        return a.messageId == b.messageId;
+    }
+    return a.timestamp == b.timestamp && a.sender == b.sender && a.content == b.content;
+}
+
+HistoryPageCache::Conversation* HistoryPageCache::find(int friendId)
+{
+    auto it = conversations.find(friendId);
+    if (it == conversations.end()) return nullptr;
+
+    // Przeniesienie na koniec listy - ostatnio używana
+    recency.splice(recency.end(), recency, it->position);
+    return &it.value();
+}
+
+HistoryPageCache::Conversation& HistoryPageCache::obtain(int friendId)
+{
+    if (Conversation* conversation = find(friendId)) {
+        return *conversation;
+    }
+
+    if (conversations.size() >= MAX_CONVERSATIONS) {
+        conversations.remove(recency.front());
+        recency.pop_front();
+    }
+    Conversation& conversation = conversations[friendId];
+    conversation.position = recency.insert(recency.end(), friendId);
+    return conversation;
+}
+
+void HistoryPageCache::trim(Conversation& conversation)
+{
+    const qsizetype excess = conversation.records.size() - MAX_MESSAGES;
+    if (excess > 0) {
+        conversation.records.remove(0, excess);
+        conversation.reachedStart = false;
+    }
+}
+
+std::optional<HistoryPageCache::Page> HistoryPageCache::result(std::optional<Page> page)
+{
+    ++(page ? hitCount : missCount);
+    return page;
+}
+
+void HistoryPageCache::storeLatest(int friendId, const QList<MessageRecord>& latest, bool hasMore)
+{
+    Conversation& conversation = obtain(friendId);
+
+    // Szukamy ostatniej zapamiętanej wiadomości na stronie - doklejamy tylko nowsze
+    qsizetype overlap = -1;
+    if (!conversation.records.isEmpty()) {
+        for (qsizetype i = latest.size() - 1; i >= 0; --i) {
+            if (sameMessage(latest[i], conversation.records.last())) {
+                overlap = i;
+                break;
+            }
+        }
+    }
+
+    if (overlap >= 0) {
+        conversation.records.append(latest.mid(overlap + 1));
+    } else {
+        // Luka między fragmentem a stroną - zostaje tylko strona
+        conversation.records = latest;
+        conversation.reachedStart = !hasMore;
+    }
+    conversation.live = true;
+    trim(conversation);
+}
+
+void HistoryPageCache::storeOlder(int friendId, const MessageRecord& before, const Page& page)
+{
+    Conversation* conversation = find(friendId);
+    if (!conversation || conversation->records.isEmpty()
+        || !sameMessage(conversation->records.first(), before))
+        return;
+
+    conversation->records = page.records + conversation->records;
+    conversation->reachedStart = !page.hasMore;
+    trim(*conversation);
+}
+
+void HistoryPageCache::append(int friendId, const MessageRecord& record)
+{
+    Conversation* conversation = find(friendId);
+    if (!conversation || !conversation->live) return;
+
+    conversation->records.append(record);
+    trim(*conversation);
+}
+
+std::optional<HistoryPageCache::Page> HistoryPageCache::latest(int friendId, int limit)
+{
+    const Conversation* conversation = find(friendId);
+    if (!conversation || !conversation->live) return result(std::nullopt);
+
+    const qsizetype start = qMax<qsizetype>(0, conversation->records.size() - limit);
+    return result(Page{conversation->records.mid(start), start > 0 || !conversation->reachedStart});
+}
+
+std::optional<HistoryPageCache::Page> HistoryPageCache::olderThan(int friendId, const MessageRecord& before,
+                                                                 int limit)
+{
+    const Conversation* conversation = find(friendId);
+    if (!conversation) return result(std::nullopt);
+
+    // Kursor jest zwykle blisko początku fragmentu
+    const QList<MessageRecord>& records = conversation->records;
+    qsizetype index = 0;
+    while (index < records.size() && !sameMessage(records[index], before)) {
+        ++index;
+    }
+    if (index == records.size() || (index == 0 && !conversation->reachedStart)) {
+        return result(std::nullopt);
+    }
+
+    const qsizetype start = qMax<qsizetype>(0, index - limit);
+    return result(Page{records.mid(start, index - start), start > 0 || !conversation->reachedStart});
+}
+
+std::optional<HistoryPageCache::Page> HistoryPageCache::newerThan(int friendId, const MessageRecord& after,
+                                                                 int limit)
+{
+    const Conversation* conversation = find(friendId);
+    if (!conversation) return result(std::nullopt);
+
+    // Kursor jest zwykle blisko końca fragmentu
+    const QList<MessageRecord>& records = conversation->records;
+    qsizetype index = records.size() - 1;
+    while (index >= 0 && !sameMessage(records[index], after)) {
+        --index;
+    }
+    const qsizetype first = index + 1;
+    if (index < 0 || (first == records.size() && !conversation->live)) {
+        return result(std::nullopt);
+    }
+
+    const qsizetype end = qMin<qsizetype>(records.size(), first + limit);
+    return result(Page{records.mid(first, end - first), end < records.size() || !conversation->live});
+}
+
+void HistoryPageCache::markStale(int friendId)
+{
+    auto it = conversations.find(friendId);
+    if (it != conversations.end()) {
+        it->live = false;
+    }
+}
+
+void HistoryPageCache::markAllStale()
+{
+    for (Conversation& conversation : conversations) {
+        conversation.live = false;
+    }
+}
+
+void HistoryPageCache::clear()
+{
+    conversations.clear();
+    recency.clear();
+}
+
+int HistoryPageCache::size(int friendId) const
+{
+    auto it = conversations.constFind(friendId);
+    return it == conversations.constEnd() ? 0 : static_cast<int>(it->records.size());
+}
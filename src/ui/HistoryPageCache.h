@@ -0,0 +1,84 @@
+/**
+ * @file HistoryPageCache.h
+ * @brief Per-conversation cache of chat history pages definition
+ * @author piotrek-pl
+ * @date 2025-02-10 15:42:18
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <list>
+#include <optional>
+#include "ChatTranscriptModel.h"
+
+/**
+ * Keeps, per conversation, one contiguous run of history received from the
+ * server, keyed by message (id when the server sends one, otherwise
+ * timestamp + sender + content). Pages "before X" / "after X" are cut from
+ * the run without a request. The run is "live" while its end is known to be
+ * the newest message: from a latest-messages response until the connection
+ * drops or a message for the conversation is missed. Older pages never
+ * change, so they stay usable after the run stops being live. Shared by all
+ * chat windows, used only from the GUI thread.
+ */
+class HistoryPageCache {
+public:
+    using MessageRecord = ChatTranscriptModel::MessageRecord;
+
+    struct Page {
+        QList<MessageRecord> records;  // Chronologicznie
+        bool hasMore = true;           // Za stroną są jeszcze wiadomości
+    };
+
+    static constexpr int MAX_CONVERSATIONS = 16;
+    static constexpr int MAX_MESSAGES = 2000;      // Na rozmowę, nadmiar usuwany od najstarszych
+
+    static HistoryPageCache& getInstance();
+
+    // Najnowsze wiadomości z serwera - dokleja nowsze od zapamiętanych albo zastępuje fragment
+    void storeLatest(int friendId, const QList<MessageRecord>& latest, bool hasMore);
+    // Strona starsza od before - zapamiętywana tylko, gdy przylega do początku fragmentu
+    void storeOlder(int friendId, const MessageRecord& before, const Page& page);
+    // Nowa wiadomość w rozmowie
+    void append(int friendId, const MessageRecord& record);
+
+    std::optional<Page> latest(int friendId, int limit);
+    std::optional<Page> olderThan(int friendId, const MessageRecord& before, int limit);
+    std::optional<Page> newerThan(int friendId, const MessageRecord& after, int limit);
+
+    // Koniec fragmentu może nie być już najnowszą wiadomością
+    void markStale(int friendId);
+    void markAllStale();
+    void clear();
+
+    int size(int friendId) const;
+    int conversationCount() const { return conversations.size(); }
+    quint64 hits() const { return hitCount; }
+    quint64 misses() const { return missCount; }
+
+    static bool sameMessage(const MessageRecord& a, const MessageRecord& b);
+
+private:
+    HistoryPageCache();
+    HistoryPageCache(const HistoryPageCache&) = delete;
+    HistoryPageCache& operator=(const HistoryPageCache&) = delete;
+
+    struct Conversation {
+        QList<MessageRecord> records;   // Ciągły fragment, chronologicznie
+        bool reachedStart = false;      // Pierwszy rekord to początek rozmowy
+        bool live = false;              // Ostatni rekord to najnowsza wiadomość
+        std::list<int>::iterator position;
+    };
+
+    Conversation* find(int friendId);
+    Conversation& obtain(int friendId);
+    void trim(Conversation& conversation);
+    std::optional<Page> result(std::optional<Page> page);
+
+    QHash<int, Conversation> conversations;
+    std::list<int> recency;  // Od najdawniej używanej
+    quint64 hitCount;
+    quint64 missCount;
+};
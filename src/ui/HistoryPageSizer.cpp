@@ -0,0 +1,34 @@
+/**
+ * @file HistoryPageSizer.cpp
+ * @brief Chat history page size from viewport and link measurements implementation
+ * @author piotrek-pl
+ * @date 2025-02-10 18:27:05
+ */
+
+#include "HistoryPageSizer.h"
+
+int HistoryPageSizer::screenRows(const Inputs& inputs)
+{
+    const int rowHeight = qMax(1, inputs.rowHeight);
+    return qMax(1, (qMax(0, inputs.viewportHeight) + rowHeight - 1) / rowHeight);
+}
+
+int HistoryPageSizer::pageSize(const Inputs& inputs)
+{
+    const int screen = screenRows(inputs);
+
+    int size = 0;
+    if (inputs.link.bytesPerMs > 0.0) {
+        // Tyle, ile łącze przesyła w czasie jednego RTT - dłuższy przesył opóźnia pierwszy ekran
+        const int messageBytes = inputs.messageBytes > 0 ? inputs.messageBytes : DEFAULT_MESSAGE_BYTES;
+        const double inFlight = inputs.link.roundTripMs * inputs.link.bytesPerMs / messageBytes;
+        size = qMax(screen, static_cast<int>(qMin(inFlight, 1e6)));
+    } else {
+        size = qMax(Protocol::ChatHistory::MESSAGE_BATCH_SIZE, UNMEASURED_SCREENS * screen);
+    }
+
+    if (inputs.ceiling > 0) {
+        size = qMin(size, inputs.ceiling);
+    }
+    return qMax(1, size);
+}
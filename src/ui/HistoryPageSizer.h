@@ -0,0 +1,38 @@
+/**
+ * @file HistoryPageSizer.h
+ * @brief Chat history page size from viewport and link measurements definition
+ * @author piotrek-pl
+ * @date 2025-02-10 18:27:05
+ */
+
+#pragma once
+
+#include "network/PendingRequests.h"
+
+/**
+ * Picks how many messages to ask for in one history page. The page always
+ * covers the visible transcript, so the first response fills the window in
+ * a single round trip. Above that it grows to what the link can deliver
+ * within about one round trip (bandwidth-delay product): slow links keep
+ * pages small, links with high latency and spare bandwidth get fewer,
+ * larger pages. Without link measurements it falls back to two screens,
+ * never less than the old fixed batch. The result is capped by the
+ * configured ceiling.
+ */
+class HistoryPageSizer {
+public:
+    struct Inputs {
+        int viewportHeight = 0;     // px
+        int rowHeight = 0;          // Średnia wysokość wiersza, px
+        int messageBytes = 0;       // Średni rozmiar wiadomości na łączu
+        PendingRequests::TransferStats link;
+        int ceiling = 0;            // 0 - bez limitu
+    };
+
+    static constexpr int UNMEASURED_SCREENS = 2;    // Bez pomiarów łącza: widok + zapas na przewijanie
+    static constexpr int DEFAULT_MESSAGE_BYTES = 160;
+
+    // Wiersze potrzebne do wypełnienia widoku
+    static int screenRows(const Inputs& inputs);
+    static int pageSize(const Inputs& inputs);
+};
@@ -0,0 +1,91 @@
+/**
+ * @file HistoryPrefetcher.cpp
+ * @brief Scroll-velocity driven prefetch of older chat history implementation
+ * @author piotrek-pl
+ * @date 2025-02-10 13:05:52
+ */
+
+#include "HistoryPrefetcher.h"
+
+HistoryPrefetcher::HistoryPrefetcher()
+    : lastValue(0)
+    , lastTime(-1)
+    , currentVelocity(0.0)
+    , direction(Direction::None)
+    , buffered(0)
+    , inFlightRequest(0)
+    , hitCount(0)
+    , missCount(0)
+{
+}
+
+bool HistoryPrefetcher::onScroll(int value, qint64 now)
+{
+    if (lastTime < 0 || now - lastTime > IDLE_RESET_MS) {
+        // Początek nowego ruchu - prędkość liczona od zera
+        currentVelocity = 0.0;
+    } else if (now > lastTime) {
+        const double sample = double(value - lastValue) / double(now - lastTime);
+        currentVelocity = VELOCITY_ALPHA * sample + (1.0 - VELOCITY_ALPHA) * currentVelocity;
+    }
+    lastValue = value;
+    lastTime = now;
+
+    Direction current = Direction::None;
+    if (currentVelocity <= -MIN_VELOCITY) {
+        current = Direction::Up;
+    } else if (currentVelocity >= MIN_VELOCITY) {
+        current = Direction::Down;
+    }
+    if (current == Direction::None) return false;
+
+    const bool reversed = (direction == Direction::Up && current == Direction::Down);
+    direction = current;
+    return reversed;
+}
+
+void HistoryPrefetcher::rebase(int value, qint64 now)
+{
+    lastValue = value;
+    lastTime = now;
+}
+
+int HistoryPrefetcher::wantedPages(int distanceToTop, qint64 roundTripMs) const
+{
+    if (currentVelocity > -MIN_VELOCITY) return 0;
+
+    // Strona musi dotrzeć, zanim użytkownik dojdzie do góry listy
+    const double timeToTop = qMax(0, distanceToTop) / -currentVelocity;
+    const double lookahead = qMax<qint64>(MIN_LOOKAHEAD_MS, 2 * roundTripMs);
+    if (timeToTop > lookahead) return 0;
+    return timeToTop < lookahead / 2 ? MAX_PAGES : 1;
+}
+
+void HistoryPrefetcher::storePage(Page page)
+{
+    buffered += page.records.size();
+    pages.append(std::move(page));
+}
+
+std::optional<HistoryPrefetcher::Page> HistoryPrefetcher::takePage()
+{
+    if (pages.isEmpty()) return std::nullopt;
+
+    Page page = pages.takeFirst();
+    buffered -= page.records.size();
+    return page;
+}
+
+const ChatTranscriptModel::MessageRecord* HistoryPrefetcher::oldestBuffered() const
+{
+    for (auto it = pages.crbegin(); it != pages.crend(); ++it) {
+        if (!it->records.isEmpty()) return &it->records.first();
+    }
+    return nullptr;
+}
+
+void HistoryPrefetcher::clearPages()
+{
+    pages.clear();
+    buffered = 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file HistoryPrefetcher.h
+ * @brief Scroll-velocity driven prefetch of older chat history definition
+ * @author piotrek-pl
+ * @date 2025-02-10 13:05:52
+ */
+
+#pragma once
+
+#include <QList>
+#include <optional>
+#include "HistoryPageCache.h"
+
+/**
+ * Estimates how soon the user will reach the top of the transcript from the
+ * scroll velocity and keeps up to MAX_PAGES pages of older history fetched
+ * and decoded ahead of the viewport. Holds no network state beyond the id
+ * of the request in flight; ChatWindow sends and cancels the requests.
+ */
+class HistoryPrefetcher {
+public:
+    using Page = HistoryPageCache::Page;
+
+    static constexpr int MAX_PAGES = 2;
+    static constexpr qint64 MIN_LOOKAHEAD_MS = 1000;
+    static constexpr qint64 DEFAULT_ROUND_TRIP_MS = 500;
+    static constexpr qint64 IDLE_RESET_MS = 400;      // Przerwa w przewijaniu zeruje prędkość
+    static constexpr double VELOCITY_ALPHA = 0.3;
+    static constexpr double MIN_VELOCITY = 0.05;      // px/ms - wolniej to brak ruchu
+
+    HistoryPrefetcher();
+
+    // true - użytkownik zawrócił z przewijania w górę na przewijanie w dół
+    bool onScroll(int value, qint64 now);
+    // Zmiana pozycji przez program (zachowanie widoku po doklejeniu wierszy)
+    void rebase(int value, qint64 now);
+    double velocity() const { return currentVelocity; }   // px/ms, ujemna - w górę
+
+    // Ile stron powinno być gotowych przy danej odległości od góry listy
+    int wantedPages(int distanceToTop, qint64 roundTripMs) const;
+
+    void setInFlight(quint64 requestId) { inFlightRequest = requestId; }
+    void clearInFlight() { inFlightRequest = 0; }
+    quint64 inFlight() const { return inFlightRequest; }
+
+    void storePage(Page page);
+    std::optional<Page> takePage();
+    int bufferedPages() const { return pages.size(); }
+    int bufferedMessages() const { return buffered; }
+    // Ostatnia pobrana strona była najstarsza
+    bool exhausted() const { return !pages.isEmpty() && !pages.last().hasMore; }
+    // Granica następnej strony: najstarsza wiadomość w buforze
+    const ChatTranscriptModel::MessageRecord* oldestBuffered() const;
+    void clearPages();
+
+    void recordHit() { ++hitCount; }
+    void recordMiss() { ++missCount; }
+    quint64 hits() const { return hitCount; }
+    quint64 misses() const { return missCount; }
+
+private:
+    enum class Direction { None, Up, Down };
+
+    int lastValue;
+    qint64 lastTime;
+    double currentVelocity;
+    Direction direction;
+
+    QList<Page> pages;   // Od najnowszej do najstarszej
+    int buffered;
+    quint64 inFlightRequest;
+
+    quint64 hitCount;
+    quint64 missCount;
+};
@@ -0,0 +1,87 @@
+/**
+ * @file InvitationStore.cpp
+ * @brief Client-side invitation state implementation
+ * @author piotrek-pl
+ * @date 2025-02-09 14:02:51
+ */
+
+#include "InvitationStore.h"
+#include <QJsonObject>
+
+InvitationStore::InvitationStore(QObject* parent)
+    : QObject(parent)
+    , receivedVersion(NO_VERSION)
+    , sentVersion(NO_VERSION)
+{
+}
+
+const QList<InvitationStore::Invitation>& InvitationStore::invitations(Kind kind) const
+{
+    return kind == Kind::Received ? received : sent;
+}
+
+qint64 InvitationStore::version(Kind kind) const
+{
+    return kind == Kind::Received ? receivedVersion : sentVersion;
+}
+
+bool InvitationStore::applyList(Kind kind, const QJsonArray& list, qint64 listVersion)
+{
+    qint64& current = versionFor(kind);
+    if (listVersion != NO_VERSION && listVersion == current) {
+        return false;
+    }
+
+    QList<Invitation>& target = listFor(kind);
+    target.clear();
+    target.reserve(list.size());
+    for (const QJsonValue& value : list) {
+        const QJsonObject inv = value.toObject();
+        Invitation invitation;
+        invitation.requestId = inv["request_id"].toInt();
+        invitation.userId = inv["user_id"].toInt();
+        invitation.username = inv["username"].toString();
+        invitation.timestamp = inv["timestamp"].toInteger();
+        target.append(invitation);
+    }
+
+    current = listVersion;
+    emit changed(kind);
+    return true;
+}
+
+template <typename Predicate>
+bool InvitationStore::removeIf(Kind kind, Predicate predicate)
+{
+    QList<Invitation>& target = listFor(kind);
+    if (target.removeIf(predicate) == 0) return false;
+
+    // Lokalna zmiana - wersja serwera już nie opisuje tej listy
+    versionFor(kind) = NO_VERSION;
+    emit changed(kind);
+    return true;
+}
+
+bool InvitationStore::removeByRequestId(Kind kind, int requestId)
+{
+    return removeIf(kind, [requestId](const Invitation& invitation) {
+        return invitation.requestId == requestId;
+    });
+}
+
+bool InvitationStore::removeByUserId(Kind kind, int userId)
+{
+    return removeIf(kind, [userId](const Invitation& invitation) {
+        return invitation.userId == userId;
+    });
+}
+
+QSet<int> InvitationStore::pendingUserIds() const
+{
+    QSet<int> userIds;
+    userIds.reserve(sent.size());
+    for (const Invitation& invitation : sent) {
+        userIds.insert(invitation.userId);
+    }
+    return userIds;
+}
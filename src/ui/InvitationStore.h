@@ -0,0 +1,64 @@
+/**
+ * @file InvitationStore.h
+ * @brief Client-side invitation state definition
+ * @author piotrek-pl
+ * @date 2025-02-09 14:02:51
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QJsonArray>
+
+/**
+ * Received and sent friend invitations. Full lists from the server replace
+ * the state unless the server reports the version already held;
+ * notifications and responses are applied as single-entry removals.
+ */
+class InvitationStore : public QObject {
+    Q_OBJECT
+
+public:
+    enum class Kind {
+        Received,
+        Sent
+    };
+
+    struct Invitation {
+        int requestId = 0;
+        int userId = 0;
+        QString username;
+        qint64 timestamp = 0;
+    };
+
+    static constexpr qint64 NO_VERSION = -1;
+
+    explicit InvitationStore(QObject* parent = nullptr);
+
+    const QList<Invitation>& invitations(Kind kind) const;
+    qint64 version(Kind kind) const;
+
+    // false - lista bez zmian (ta sama wersja), stan nie jest przebudowywany
+    bool applyList(Kind kind, const QJsonArray& list, qint64 listVersion);
+    bool removeByRequestId(Kind kind, int requestId);
+    bool removeByUserId(Kind kind, int userId);
+
+    // Użytkownicy z wysłanym, oczekującym zaproszeniem
+    QSet<int> pendingUserIds() const;
+
+signals:
+    void changed(InvitationStore::Kind kind);
+
+private:
+    QList<Invitation>& listFor(Kind kind) { return kind == Kind::Received ? received : sent; }
+    qint64& versionFor(Kind kind) { return kind == Kind::Received ? receivedVersion : sentVersion; }
+    template <typename Predicate>
+    bool removeIf(Kind kind, Predicate predicate);
+
+    QList<Invitation> received;
+    QList<Invitation> sent;
+    qint64 receivedVersion;
+    qint64 sentVersion;
+};
@@ -7,14 +7,18 @@
 
 #include "InvitationsDialog.h"
 #include "ui_InvitationsDialog.h"
+#include "NotificationQueue.h"
 #include "network/Protocol.h"
-#include <QMessageBox>
 #include <QDateTime>
 
 InvitationsDialog::InvitationsDialog(NetworkManager& networkManager, QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::InvitationsDialog)
     , networkManager(networkManager)
+    , refreshScheduled(false)
+    , refreshQueued(false)
+    , refreshInFlight(0)
+    , refreshRequests(0)
 {
     ui->setupUi(this);
     setWindowTitle("Friend Invitations");
@@ -36,32 +40,112 @@ void InvitationsDialog::setupConnections()
             this, &InvitationsDialog::onRejectClicked);
     connect(ui->cancelButton, &QPushButton::clicked,
             this, &InvitationsDialog::onCancelClicked);
+    connect(&store, &InvitationStore::changed,
+            this, &InvitationsDialog::onStoreChanged);
+
+    using Protocol::MessageType::Id;
+    auto route = [this](Id type, void (InvitationsDialog::*handler)(const QJsonObject&)) {
+        networkManager.router().subscribe(this, type, [this, handler](const QJsonObject& json) {
+            (this->*handler)(json);
+        });
+    };
+
+    route(Id::RECEIVED_INVITATIONS_RESPONSE, &InvitationsDialog::handleReceivedInvitationsResponse);
+    route(Id::SENT_INVITATIONS_RESPONSE, &InvitationsDialog::handleSentInvitationsResponse);
+    route(Id::FRIEND_REQUEST_ACCEPT_RESPONSE, &InvitationsDialog::handleFriendRequestAcceptResponse);
+    route(Id::FRIEND_REQUEST_REJECT_RESPONSE, &InvitationsDialog::handleFriendRequestRejectResponse);
+    route(Id::CANCEL_FRIEND_REQUEST_RESPONSE, &InvitationsDialog::handleCancelFriendRequestResponse);
+    route(Id::INVITATION_STATUS_CHANGED, &InvitationsDialog::handleInvitationStatusChanged);
+    route(Id::FRIEND_REQUEST_CANCELLED_NOTIFICATION, &InvitationsDialog::handleFriendRequestCancelledNotification);
 }
 
 void InvitationsDialog::refreshInvitations()
 {
-    QJsonObject receivedRequest = Protocol::MessageStructure::createGetReceivedInvitationsRequest();
-    networkManager.sendMessage(receivedRequest);
+    if (refreshScheduled) return;
 
-    QJsonObject sentRequest = Protocol::MessageStructure::createGetSentInvitationsRequest();
-    networkManager.sendMessage(sentRequest);
+    refreshScheduled = true;
+    QMetaObject::invokeMethod(this, &InvitationsDialog::sendRefresh, Qt::QueuedConnection);
+}
+
+void InvitationsDialog::sendRefresh()
+{
+    refreshScheduled = false;
+    if (refreshInFlight > 0) {
+        // Po nadejściu bieżących list pobierzemy je jeszcze raz
+        refreshQueued = true;
+        return;
+    }
+
+    // Listy przychodzą przez router; tu tylko timeout, rozłączenie lub wysyłka bez połączenia
+    using Kind = InvitationStore::Kind;
+    using Protocol::MessageType::Id;
+    auto onFailure = [this]() { onRefreshFailed(); };
+    refreshInFlight = 2;
+    ++refreshRequests;
+    networkManager.sendRequest(
+        Protocol::MessageStructure::createGetReceivedInvitationsRequest(store.version(Kind::Received)),
+        Id::RECEIVED_INVITATIONS_RESPONSE, this, nullptr, onFailure);
+    networkManager.sendRequest(
+        Protocol::MessageStructure::createGetSentInvitationsRequest(store.version(Kind::Sent)),
+        Id::SENT_INVITATIONS_RESPONSE, this, nullptr, onFailure);
+}
+
+void InvitationsDialog::onRefreshFailed()
+{
+    // Lista, która nie przyjdzie, nie może blokować kolejnych odświeżeń
+    refreshInFlight = qMax(0, refreshInFlight - 1);
+    if (refreshInFlight == 0) {
+        refreshQueued = false;
+    }
+}
+
+void InvitationsDialog::applyListResponse(InvitationStore::Kind kind, const QJsonObject& message)
+{
+    // Serwer z wersjonowaniem może pominąć listę, gdy się nie zmieniła
+    if (!message["unchanged"].toBool()) {
+        const qint64 version = message.contains("version") ? message["version"].toInteger()
+                                                           : InvitationStore::NO_VERSION;
+        store.applyList(kind, message["invitations"].toArray(), version);
+    }
+
+    refreshInFlight = qMax(0, refreshInFlight - 1);
+    if (refreshInFlight == 0 && refreshQueued) {
+        refreshQueued = false;
+        refreshInvitations();
+    }
 }
 
 void InvitationsDialog::handleReceivedInvitationsResponse(const QJsonObject& message)
 {
-    updateReceivedInvitations(message["invitations"].toArray());
+    applyListResponse(InvitationStore::Kind::Received, message);
 }
 
 void InvitationsDialog::handleSentInvitationsResponse(const QJsonObject& message)
 {
-    updateSentInvitations(message["invitations"].toArray());
+    applyListResponse(InvitationStore::Kind::Sent, message);
+}
+
+bool InvitationsDialog::removeAnswered(InvitationStore::Kind kind, QQueue<int>& pendingActions,
+                                       const QJsonObject& message)
+{
+    const int requestId = message.contains("request_id") ? message["request_id"].toInt()
+                          : !pendingActions.isEmpty()     ? pendingActions.head()
+                                                          : 0;
+    if (!pendingActions.isEmpty()) {
+        pendingActions.dequeue();
+    }
+    return requestId != 0 && store.removeByRequestId(kind, requestId);
 }
 
 void InvitationsDialog::handleFriendRequestAcceptResponse(const QJsonObject& message)
 {
     if (message["status"].toString() == "success") {
         handleInvitationStatusChange(message);
-        refreshInvitations();
+        if (!removeAnswered(InvitationStore::Kind::Received, pendingAccepts, message)) {
+            refreshInvitations();
+        }
+    } else if (!pendingAccepts.isEmpty()) {
+        pendingAccepts.dequeue();
     }
 }
 
@@ -69,7 +153,11 @@ void InvitationsDialog::handleFriendRequestRejectResponse(const QJsonObject& mes
 {
     if (message["status"].toString() == "success") {
         handleInvitationStatusChange(message);
-        refreshInvitations();
+        if (!removeAnswered(InvitationStore::Kind::Received, pendingRejects, message)) {
+            refreshInvitations();
+        }
+    } else if (!pendingRejects.isEmpty()) {
+        pendingRejects.dequeue();
     }
     showResponseMessage("Reject Request", message["message"].toString());
 }
@@ -78,7 +166,11 @@ void InvitationsDialog::handleCancelFriendRequestResponse(const QJsonObject& mes
 {
     if (message["status"].toString() == "success") {
         handleInvitationStatusChange(message);
-        refreshInvitations();
+        if (!removeAnswered(InvitationStore::Kind::Sent, pendingCancels, message)) {
+            refreshInvitations();
+        }
+    } else if (!pendingCancels.isEmpty()) {
+        pendingCancels.dequeue();
     }
     showResponseMessage("Cancel Request", message["message"].toString());
 }
@@ -86,95 +178,62 @@ void InvitationsDialog::handleCancelFriendRequestResponse(const QJsonObject& mes
 void InvitationsDialog::handleInvitationStatusChanged(const QJsonObject& message)
 {
     handleInvitationStatusChange(message);
-    refreshInvitations();
-}
 
-void InvitationsDialog::handleFriendRequestCancelledNotification(const QJsonObject& message)
-{
-    refreshInvitations();
-    showResponseMessage("Friend Request Cancelled", "A friend request has been cancelled.");
+    // Odbiorca odpowiedział na nasze zaproszenie - znika z wysłanych
+    const bool removed = message.contains("request_id")
+        ? store.removeByRequestId(InvitationStore::Kind::Sent, message["request_id"].toInt())
+        : message.contains("user_id")
+              && store.removeByUserId(InvitationStore::Kind::Sent, message["user_id"].toInt());
+    if (!removed) {
+        refreshInvitations();
+    }
 }
 
-void InvitationsDialog::onMessageReceived(const QJsonObject& message)
+void InvitationsDialog::handleFriendRequestCancelledNotification(const QJsonObject& message)
 {
-    QString type = message["type"].toString();
-
-    if (type == Protocol::MessageType::RECEIVED_INVITATIONS_RESPONSE) {
-        handleReceivedInvitationsResponse(message);
-    }
-    else if (type == Protocol::MessageType::SENT_INVITATIONS_RESPONSE) {
-        handleSentInvitationsResponse(message);
-    }
-    else if (type == Protocol::MessageType::FRIEND_REQUEST_ACCEPT_RESPONSE) {
-        handleFriendRequestAcceptResponse(message);
+    // Nadawca wycofał zaproszenie - znika z odebranych
+    bool removed = false;
+    if (message.contains("request_id")) {
+        removed = store.removeByRequestId(InvitationStore::Kind::Received, message["request_id"].toInt());
+    } else if (message.contains("from_user_id")) {
+        removed = store.removeByUserId(InvitationStore::Kind::Received, message["from_user_id"].toInt());
     }
-    else if (type == Protocol::MessageType::FRIEND_REQUEST_REJECT_RESPONSE) {
-        handleFriendRequestRejectResponse(message);
-    }
-    else if (type == Protocol::MessageType::CANCEL_FRIEND_REQUEST_RESPONSE) {
-        handleCancelFriendRequestResponse(message);
-    }
-    else if (type == Protocol::MessageType::INVITATION_STATUS_CHANGED) {
-        handleInvitationStatusChanged(message);
-    }
-    else if (type == Protocol::MessageType::FRIEND_REQUEST_CANCELLED_NOTIFICATION) {
-        handleFriendRequestCancelledNotification(message);
+    if (!removed) {
+        refreshInvitations();
     }
+    showResponseMessage("Friend Request Cancelled", "A friend request has been cancelled.");
 }
 
-void InvitationsDialog::updateReceivedInvitations(const QJsonArray& invitations)
+void InvitationsDialog::onStoreChanged(InvitationStore::Kind kind)
 {
-    ui->receivedList->clear();
-    receivedInvitations.clear();
-
-    for (const QJsonValue &value : invitations) {
-        QJsonObject inv = value.toObject();
-        Invitation invitation;
-        invitation.requestId = inv["request_id"].toInt();
-        invitation.username = inv["username"].toString();
-        invitation.timestamp = inv["timestamp"].toInteger();
-
-        receivedInvitations.append(invitation);
-
-        QString timeStr = QDateTime::fromMSecsSinceEpoch(invitation.timestamp)
-                              .toString("yyyy-MM-dd HH:mm:ss");
-        QString displayText = QString("%1 (%2)").arg(invitation.username, timeStr);
-        QListWidgetItem* item = new QListWidgetItem(displayText);
-        item->setData(Qt::UserRole, invitation.requestId);
-        ui->receivedList->addItem(item);
+    if (kind == InvitationStore::Kind::Received) {
+        renderInvitations(ui->receivedList, store.invitations(kind));
+    } else {
+        renderInvitations(ui->sentList, store.invitations(kind));
+        emitPendingInvitations();
     }
-
     updateInvitationsCount();
 }
 
-void InvitationsDialog::updateSentInvitations(const QJsonArray& invitations)
+void InvitationsDialog::renderInvitations(QListWidget* list,
+                                          const QList<InvitationStore::Invitation>& invitations)
 {
-    ui->sentList->clear();
-    sentInvitations.clear();
-    QSet<int> pendingUserIds;
-
-    for (const QJsonValue &value : invitations) {
-        QJsonObject inv = value.toObject();
-        Invitation invitation;
-        invitation.requestId = inv["request_id"].toInt();
-        invitation.userId = inv["user_id"].toInt();
-        invitation.username = inv["username"].toString();
-        invitation.timestamp = inv["timestamp"].toInteger();
-
-        sentInvitations.append(invitation);
-        pendingUserIds.insert(invitation.userId);
+    list->clear();
 
+    for (const InvitationStore::Invitation& invitation : invitations) {
         QString timeStr = QDateTime::fromMSecsSinceEpoch(invitation.timestamp)
                               .toString("yyyy-MM-dd HH:mm:ss");
         QString displayText = QString("%1 (%2)").arg(invitation.username, timeStr);
         QListWidgetItem* item = new QListWidgetItem(displayText);
         item->setData(Qt::UserRole, invitation.requestId);
         item->setData(Qt::UserRole + 1, invitation.userId);
-        ui->sentList->addItem(item);
+        list->addItem(item);
     }
+}
 
-    updateInvitationsCount();
-    emit pendingInvitationsChanged(pendingUserIds);
+void InvitationsDialog::emitPendingInvitations()
+{
+    emit pendingInvitationsChanged(store.pendingUserIds());
 }
 
 InvitationsDialog::SelectedInvitation InvitationsDialog::getSelectedInvitation(QListWidget* list)
@@ -203,6 +262,7 @@ void InvitationsDialog::onAcceptClicked()
 
     QJsonObject request = Protocol::MessageStructure::createFriendRequestAccept(selected.requestId);
     networkManager.sendMessage(request);
+    pendingAccepts.enqueue(selected.requestId);
 }
 
 void InvitationsDialog::onRejectClicked()
@@ -215,6 +275,7 @@ void InvitationsDialog::onRejectClicked()
 
     QJsonObject request = Protocol::MessageStructure::createFriendRequestReject(selected.requestId);
     networkManager.sendMessage(request);
+    pendingRejects.enqueue(selected.requestId);
 }
 
 void InvitationsDialog::onCancelClicked()
@@ -227,26 +288,24 @@ void InvitationsDialog::onCancelClicked()
 
     QJsonObject request = Protocol::MessageStructure::createCancelFriendRequest(selected.requestId);
     networkManager.sendMessage(request);
+    pendingCancels.enqueue(selected.requestId);
 }
 
 void InvitationsDialog::updateInvitationsCount()
 {
-    ui->tabWidget->setTabText(0, QString("Received (%1)").arg(receivedInvitations.size()));
-    ui->tabWidget->setTabText(1, QString("Sent (%1)").arg(sentInvitations.size()));
+    ui->tabWidget->setTabText(0, QString("Received (%1)").arg(store.invitations(InvitationStore::Kind::Received).size()));
+    ui->tabWidget->setTabText(1, QString("Sent (%1)").arg(store.invitations(InvitationStore::Kind::Sent).size()));
 }
 
 void InvitationsDialog::clearLists()
 {
-    ui->receivedList->clear();
-    ui->sentList->clear();
-    receivedInvitations.clear();
-    sentInvitations.clear();
-    updateInvitationsCount();
+    store.applyList(InvitationStore::Kind::Received, QJsonArray(), InvitationStore::NO_VERSION);
+    store.applyList(InvitationStore::Kind::Sent, QJsonArray(), InvitationStore::NO_VERSION);
 }
 
 void InvitationsDialog::showResponseMessage(const QString& title, const QString& message)
 {
-    QMessageBox::information(this, title, message);
+    NotificationQueue::getInstance().information(this, title, message);
 }
 
 void InvitationsDialog::handleInvitationStatusChange(const QJsonObject& message)
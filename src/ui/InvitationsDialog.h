@@ -14,7 +14,9 @@
 #include <QJsonArray>
 #include <QSet>
 #include <QListWidget>
+#include <QQueue>
 #include "network/NetworkManager.h"
+#include "InvitationStore.h"
 
 namespace Ui {
 class InvitationsDialog;
@@ -27,6 +29,10 @@ public:
     explicit InvitationsDialog(NetworkManager& networkManager, QWidget *parent = nullptr);
     ~InvitationsDialog();
 
+    const InvitationStore& invitationStore() const { return store; }
+    // Liczba faktycznie wysłanych odświeżeń (po scaleniu)
+    quint64 refreshRequestCount() const { return refreshRequests; }
+
     struct SelectedInvitation {
         bool isValid;
         int requestId;
@@ -42,7 +48,7 @@ signals:
     void invitationStatusChanged(int userId);
 
 public slots:
-    void onMessageReceived(const QJsonObject& message);
+    // Odświeżenia z jednej iteracji pętli zdarzeń są scalane w jedno
     void refreshInvitations();
 
 private slots:
@@ -50,6 +56,9 @@ private slots:
     void onAcceptClicked();
     void onRejectClicked();
     void onCancelClicked();
+    void sendRefresh();
+    void onRefreshFailed();
+    void onStoreChanged(InvitationStore::Kind kind);
 
 private:
     // Setup
@@ -65,9 +74,11 @@ private:
     void handleFriendRequestCancelledNotification(const QJsonObject& message);
 
     // UI updates
-    void updateReceivedInvitations(const QJsonArray& invitations);
-    void updateSentInvitations(const QJsonArray& invitations);
+    void renderInvitations(QListWidget* list, const QList<InvitationStore::Invitation>& invitations);
     void updateInvitationsCount();
+    void applyListResponse(InvitationStore::Kind kind, const QJsonObject& message);
+    // Usuwa zaproszenie, którego dotyczy odpowiedź; false - nie wiadomo którego
+    bool removeAnswered(InvitationStore::Kind kind, QQueue<int>& pendingActions, const QJsonObject& message);
     void clearLists();
 
     // Helper methods
@@ -81,15 +92,17 @@ private:
     Ui::InvitationsDialog *ui;
     NetworkManager& networkManager;
 
-    struct Invitation {
-        int requestId;
-        int userId;
-        QString username;
-        qint64 timestamp;
-    };
+    InvitationStore store;
+
+    // Zaproszenia czekające na odpowiedź serwera (odpowiedzi przychodzą w kolejności)
+    QQueue<int> pendingAccepts;
+    QQueue<int> pendingRejects;
+    QQueue<int> pendingCancels;
 
-    QList<Invitation> receivedInvitations;
-    QList<Invitation> sentInvitations;
+    bool refreshScheduled;
+    bool refreshQueued;      // Odświeżenie zażądane w trakcie trwającego
+    int refreshInFlight;     // Listy, na które czekamy
+    quint64 refreshRequests;
 };
 
 #endif // INVITATIONSDIALOG_H
@@ -8,15 +8,22 @@
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
 #include "SearchDialog.h"
+#include "StatusIconCache.h"
+#include "NotificationQueue.h"
+#include "HistoryPageCache.h"
+#include "storage/MessageStore.h"
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QMessageBox>
 #include <QScrollBar>
+#include <QStandardPaths>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , networkManager(NetworkManager::getInstance())
+    , chatWindowPool(new ChatWindowPool(ConfigManager::getInstance().getChatConfig().windowPoolSize, this))
+    , friendsModel(new FriendsModel(this))
     , searchDialog(nullptr)
     , invitationsDialog(nullptr)
 {
@@ -28,12 +35,17 @@ MainWindow::MainWindow(QWidget *parent)
     setupNetworkConnections();
     setupInvitationsMenu();
 
+    // Okna czatu budowane po wyświetleniu głównego okna
+    QTimer::singleShot(0, chatWindowPool, &ChatWindowPool::warmUp);
+
     LOG_INFO("MainWindow initialized");
 }
 
 MainWindow::~MainWindow()
 {
     sendLogoutRequest();
+    qDeleteAll(chatWindows);
+    chatWindows.clear();
     delete searchDialog;
     delete ui;
     LOG_INFO("MainWindow destroyed");
@@ -42,10 +54,11 @@ MainWindow::~MainWindow()
 // Initialization methods
 void MainWindow::setupStatusComboBox()
 {
+    StatusIconCache& icons = StatusIconCache::getInstance();
     ui->statusComboBox->clear();
-    ui->statusComboBox->addItem(QIcon(":/resources/icons/status_online.svg"), "Online", Protocol::UserStatus::ONLINE);
-    ui->statusComboBox->addItem(QIcon(":/resources/icons/status_away.svg"), "Away", Protocol::UserStatus::AWAY);
-    ui->statusComboBox->addItem(QIcon(":/resources/icons/status_busy.svg"), "Busy", Protocol::UserStatus::BUSY);
+    ui->statusComboBox->addItem(icons.icon(FriendsModel::Status::Online, false), "Online", Protocol::UserStatus::ONLINE);
+    ui->statusComboBox->addItem(icons.icon(FriendsModel::Status::Away, false), "Away", Protocol::UserStatus::AWAY);
+    ui->statusComboBox->addItem(icons.icon(FriendsModel::Status::Busy, false), "Busy", Protocol::UserStatus::BUSY);
     ui->statusComboBox->setIconSize(QSize(16, 16));
 
     for (int i = 0; i < ui->statusComboBox->count(); i++) {
@@ -55,6 +68,8 @@ void MainWindow::setupStatusComboBox()
 
 void MainWindow::setupFriendsList()
 {
+    ui->friendsList->setModel(friendsModel);
+    ui->friendsList->setEditTriggers(QAbstractItemView::NoEditTriggers);
     ui->friendsList->setIconSize(QSize(24, 24));
     ui->friendsList->setSpacing(0);
     ui->friendsList->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -67,13 +82,15 @@ void MainWindow::setupUIConnections()
     connect(ui->actionSearch, &QAction::triggered, this, &MainWindow::onMenuSearchTriggered);
     connect(ui->actionExit, &QAction::triggered, this, &MainWindow::onMenuExitTriggered);
     connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::onMenuAboutTriggered);
-    connect(ui->friendsList, &QListWidget::itemDoubleClicked, this, &MainWindow::openChatWindow);
+    connect(ui->friendsList, &QListView::doubleClicked, this, &MainWindow::openChatWindow);
     connect(ui->friendsList, &QWidget::customContextMenuRequested,
             this, &MainWindow::showFriendsContextMenu);
 }
 
 void MainWindow::initializeUI()
 {
+    // Ikony statusu renderowane raz dla rozmiarów listy i combo boxa
+    StatusIconCache::getInstance().warmUp({16, 24}, devicePixelRatioF());
     setupStatusComboBox();
     setupFriendsList();
     setupUIConnections();
@@ -86,8 +103,7 @@ void MainWindow::setupNetworkConnections()
 
     connect(&networkManager, &NetworkManager::connectionStatusChanged,
             this, &MainWindow::onConnectionStatusChanged);
-    connect(&networkManager, &NetworkManager::messageReceived,
-            this, &MainWindow::onMessageReceived);
+    setupMessageRoutes();
     connect(&networkManager, &NetworkManager::error,
             this, &MainWindow::onNetworkError);
     connect(&networkManager, &NetworkManager::disconnected,
@@ -99,6 +115,34 @@ void MainWindow::setupNetworkConnections()
     }
 }
 
+void MainWindow::setupMessageRoutes()
+{
+    using Protocol::MessageType::Id;
+    MessageRouter& router = networkManager.router();
+    router.unsubscribe(this);
+
+    auto route = [this, &router](Id type, void (MainWindow::*handler)(const QJsonObject&)) {
+        router.subscribe(this, type, [this, handler](const QJsonObject& json) {
+            (this->*handler)(json);
+        });
+    };
+
+    route(Id::SEARCH_USERS_RESPONSE, &MainWindow::handleSearchResponse);
+    route(Id::FRIEND_REQUEST_RECEIVED, &MainWindow::handleFriendRequest);
+    route(Id::FRIEND_REQUEST_ACCEPT_RESPONSE, &MainWindow::handleFriendRequestAcceptResponse);
+    route(Id::FRIEND_REQUEST_REJECT_RESPONSE, &MainWindow::handleFriendRequestRejectResponse);
+    route(Id::UNREAD_FROM, &MainWindow::handleUnreadMessages);
+    route(Id::LOGIN_RESPONSE, &MainWindow::handleLoginResponse);
+    route(Id::LATEST_MESSAGES_RESPONSE, &MainWindow::handleLatestMessages);
+    route(Id::MESSAGE_RESPONSE, &MainWindow::handleMessageResponse);
+    route(Id::NEW_MESSAGES, &MainWindow::handleNewMessage);
+    route(Id::REMOVE_FRIEND_RESPONSE, &MainWindow::handleRemoveFriendResponse);
+    route(Id::FRIEND_REMOVED, &MainWindow::handleFriendRemoved);
+    route(Id::FRIENDS_LIST_RESPONSE, &MainWindow::handleFriendsListUpdate);
+    route(Id::FRIENDS_STATUS_UPDATE, &MainWindow::handleFriendsListUpdate);
+    route(Id::FRIENDS_STATUS_DELTA, &MainWindow::handleFriendsStatusDelta);
+}
+
 // Message handling methods
 void MainWindow::handleSearchResponse(const QJsonObject& json)
 {
@@ -112,35 +156,37 @@ void MainWindow::handleFriendRequest(const QJsonObject& json)
     int fromUserId = json["from_user_id"].toInt();
     QString username = json["username"].toString();
 
-    QMessageBox::StandardButton reply = QMessageBox::question(this,
-                                                              "Friend Request",
-                                                              QString("%1 wants to add you to their friends list. Accept?").arg(username),
-                                                              QMessageBox::Yes | QMessageBox::No);
-
-    QJsonObject response;
-    if (reply == QMessageBox::Yes) {
-        response = Protocol::MessageStructure::createFriendRequestAccept(fromUserId);
-        LOG_INFO(QString("Accepted friend request from user %1").arg(username));
-    } else {
-        response = Protocol::MessageStructure::createFriendRequestReject(fromUserId);
-        LOG_INFO(QString("Rejected friend request from user %1").arg(username));
-    }
-
-    networkManager.sendMessage(response);
+    // Odpowiedź użytkownika przychodzi później - handler wraca od razu
+    NotificationQueue::getInstance().question(
+        this, "Friend Request",
+        QString("%1 wants to add you to their friends list. Accept?").arg(username),
+        this, [this, fromUserId, username](bool accepted) {
+            QJsonObject response;
+            if (accepted) {
+                response = Protocol::MessageStructure::createFriendRequestAccept(fromUserId);
+                LOG_INFO(QString("Accepted friend request from user %1").arg(username));
+            } else {
+                response = Protocol::MessageStructure::createFriendRequestReject(fromUserId);
+                LOG_INFO(QString("Rejected friend request from user %1").arg(username));
+            }
+
+            networkManager.sendMessage(response);
+            refreshInvitationsDialog();
+        });
     refreshInvitationsDialog();
 }
 
 void MainWindow::handleFriendRequestAcceptResponse(const QJsonObject& json)
 {
     if (json["status"].toString() == "success") {
-        QMessageBox::information(this, "Success", "Friend added successfully!");
+        NotificationQueue::getInstance().information(this, "Success", "Friend added successfully!");
         QJsonObject getFriendsRequest = Protocol::MessageStructure::createGetFriendsList();
         networkManager.sendMessage(getFriendsRequest);
         refreshInvitationsDialog();
         LOG_INFO("Friend request accepted successfully");
     } else {
         QString errorMessage = json["message"].toString();
-        QMessageBox::warning(this, "Error", "Failed to add friend: " + errorMessage);
+        NotificationQueue::getInstance().warning(this, "Error", "Failed to add friend: " + errorMessage);
         LOG_WARNING(QString("Failed to add friend: %1").arg(errorMessage));
     }
 }
@@ -172,6 +218,14 @@ void MainWindow::handleLoginResponse(const QJsonObject& json)
 {
     if (json["status"].toString() == "success") {
         currentUsername = json["username"].toString();
+        // Historia poprzedniego użytkownika nie może trafić do okien nowego
+        HistoryPageCache::getInstance().clear();
+        networkManager.readReceipts().clear();
+        if (ConfigManager::getInstance().getChatConfig().localHistory) {
+            MessageStore::getInstance().open(
+                QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                + "/history/" + currentUsername);
+        }
         if (json.contains("friends")) {
             updateFriendsList(json["friends"].toArray());
         }
@@ -207,14 +261,23 @@ void MainWindow::handleNewMessage(const QJsonObject& json)
     bool shouldShowNotification = !chatWindows.contains(fromId) ||
                                   (chatWindows.contains(fromId) && !chatWindows[fromId]->isVisible());
 
+    // Otwarte okno czatu dostaje wiadomość bezpośrednio z MessageRouter
+    if (!chatWindows.contains(fromId)) {
+        // Cache rozmowy pozostaje aktualny - ponowne otwarcie okna bez zapytania o historię
+        const QString friendName = friendsModel->nameOf(fromId);
+        if (friendName.isEmpty()) {
+            HistoryPageCache::getInstance().markStale(fromId);
+        } else {
+            ChatTranscriptModel::MessageRecord record;
+            record.sender = friendName;
+            record.content = json["content"].toString();
+            record.timestamp = static_cast<qint64>(json["timestamp"].toDouble());
+            HistoryPageCache::getInstance().append(fromId, record);
+        }
+    }
+
     if (shouldShowNotification) {
         handleUnreadMessage(fromId, getFriendStatus(fromId));
-        if (chatWindows.contains(fromId)) {
-            chatWindows[fromId]->processMessage(json);
-        }
-    } else {
-        LOG_DEBUG(QString("Forwarding message to open chat window for user ID: %1").arg(fromId));
-        chatWindows[fromId]->processMessage(json);
     }
 }
 
@@ -222,11 +285,11 @@ void MainWindow::handleRemoveFriendResponse(const QJsonObject& json)
 {
     if (json["status"].toString() == "success") {
         LOG_INFO("Friend removed successfully");
-        QMessageBox::information(this, "Success", "Friend removed successfully");
+        NotificationQueue::getInstance().information(this, "Success", "Friend removed successfully");
         refreshInvitationsDialog();
     } else {
         LOG_WARNING("Failed to remove friend");
-        QMessageBox::warning(this, "Error", "Failed to remove friend");
+        NotificationQueue::getInstance().warning(this, "Error", "Failed to remove friend");
     }
 }
 
@@ -235,8 +298,8 @@ void MainWindow::handleFriendRemoved(const QJsonObject& json)
     int friendId = json["friend_id"].toInt();
     closeChatWindow(friendId);
 
-    QMessageBox::information(this, "Friend Removed",
-                             "You have been removed from a friend's contact list.");
+    NotificationQueue::getInstance().information(this, "Friend Removed",
+                                                 "You have been removed from a friend's contact list.");
     refreshInvitationsDialog();
 }
 
@@ -245,24 +308,33 @@ void MainWindow::handleFriendsListUpdate(const QJsonObject& json)
     updateFriendsList(json["friends"].toArray());
 }
 
+void MainWindow::handleFriendsStatusDelta(const QJsonObject& json)
+{
+    friendsModel->applyDelta(json);
+
+    for (const QJsonValue& addedValue : json["added"].toArray()) {
+        const int friendId = addedValue.toObject()["id"].toInt();
+        if (unreadMessagesMap.value(friendId, false)) {
+            friendsModel->setUnread(friendId, true);
+        }
+    }
+}
+
 // Chat window management methods
 void MainWindow::processChatMessage(const QJsonObject& json, int chatWindowId)
 {
     if (chatWindows.contains(chatWindowId)) {
-        chatWindows[chatWindowId]->processMessage(json);
+        chatWindows[chatWindowId]->processMessage(Protocol::MessageType::Id::MESSAGE_RESPONSE, json);
     } else {
         QString sender = json["sender"].toString();
         if (json["recipient"].toString() == currentUsername) {
-            ChatWindow* chatWindow = new ChatWindow(sender, chatWindowId);
-            chatWindows[chatWindowId] = chatWindow;
-
-            connect(chatWindow, &ChatWindow::destroyed, [this, chatWindowId]() {
-                chatWindows.remove(chatWindowId);
-            });
-
-            chatWindow->processMessage(json);
+            ChatWindow* chatWindow = acquireChatWindow(sender, chatWindowId);
+            chatWindow->processMessage(Protocol::MessageType::Id::MESSAGE_RESPONSE, json);
             chatWindow->show();
             chatWindow->activateWindow();
+        } else {
+            // Wiadomość z innej sesji - cache rozmowy jej nie zawiera
+            HistoryPageCache::getInstance().markStale(chatWindowId);
         }
     }
 }
@@ -273,12 +345,12 @@ void MainWindow::handleUnreadMessage(int fromId, const QString& status)
     updateIconForUser(fromId, status, true);
 }
 
-void MainWindow::openChatWindow(QListWidgetItem* item)
+void MainWindow::openChatWindow(const QModelIndex& index)
 {
-    if (!item) return;
+    if (!index.isValid()) return;
 
-    int friendId = item->data(Qt::UserRole).toInt();
-    QString friendName = item->text();
+    int friendId = index.data(FriendsModel::FriendIdRole).toInt();
+    QString friendName = index.data(Qt::DisplayRole).toString();
 
     if (chatWindows.contains(friendId)) {
         chatWindows[friendId]->show();
@@ -288,34 +360,32 @@ void MainWindow::openChatWindow(QListWidgetItem* item)
             unreadMessagesMap[friendId] = false;
             QString status = getFriendStatus(friendId);
             updateIconForUser(friendId, status, false);
-
-            QJsonObject readMessage = Protocol::MessageStructure::createMessageRead(friendId);
-            networkManager.sendMessage(readMessage);
         }
         return;
     }
 
-    ChatWindow* chatWindow = new ChatWindow(friendName, friendId);
-    chatWindows[friendId] = chatWindow;
+    ChatWindow* chatWindow = acquireChatWindow(friendName, friendId);
 
     if (unreadMessagesMap[friendId]) {
         unreadMessagesMap[friendId] = false;
         QString status = getFriendStatus(friendId);
         updateIconForUser(friendId, status, false);
-
-        QJsonObject readMessage = Protocol::MessageStructure::createMessageRead(friendId);
-        networkManager.sendMessage(readMessage);
     }
 
-    connect(chatWindow, &QObject::destroyed, this, [this, friendId]() {
-        chatWindows.remove(friendId);
-        onChatWindowClosed(friendId);
-    });
-
+    // Potwierdzenie odczytu wysyła okno po pokazaniu (ReadReceiptAggregator)
     chatWindow->show();
     chatWindow->activateWindow();
 }
 
+ChatWindow* MainWindow::acquireChatWindow(const QString& friendName, int friendId)
+{
+    ChatWindow* chatWindow = chatWindowPool->acquire(friendName, friendId);
+    chatWindows[friendId] = chatWindow;
+    // Okno z puli mogło być już połączone przy wcześniejszym użyciu
+    connect(chatWindow, &ChatWindow::closed, this, &MainWindow::onChatWindowClosed, Qt::UniqueConnection);
+    return chatWindow;
+}
+
 void MainWindow::closeChatWindow(int friendId)
 {
     if (chatWindows.contains(friendId)) {
@@ -330,82 +400,34 @@ void MainWindow::closeChatWindow(int friendId)
 void MainWindow::updateFriendsList(const QJsonArray& friends)
 {
     LOG_INFO(QString("Updating friends list with %1 friends").arg(friends.size()));
-    ui->friendsList->clear();
-
-    QList<QListWidgetItem*> onlineFriends;
-    QList<QListWidgetItem*> awayFriends;
-    QList<QListWidgetItem*> busyFriends;
-    QList<QListWidgetItem*> offlineFriends;
-
-    for (const QJsonValue &friendValue : friends) {
-        QJsonObject friendObj = friendValue.toObject();
-        QString friendName = friendObj["username"].toString();
-        QString friendStatus = friendObj["status"].toString();
-        int friendId = friendObj["id"].toInt();
-
-        bool hasUnreadMessages = unreadMessagesMap.value(friendId, false);
-
-        QListWidgetItem* item = new QListWidgetItem();
-        item->setText(friendName);
-        item->setData(Qt::UserRole, friendId);
-        item->setData(Qt::UserRole + 1, friendStatus);
-        item->setIcon(getStatusIcon(friendStatus, hasUnreadMessages));
-        item->setForeground(Qt::black);
-
-        if (friendStatus == Protocol::UserStatus::ONLINE)
-            onlineFriends.append(item);
-        else if (friendStatus == Protocol::UserStatus::AWAY)
-            awayFriends.append(item);
-        else if (friendStatus == Protocol::UserStatus::BUSY)
-            busyFriends.append(item);
-        else
-            offlineFriends.append(item);
-    }
-
-    for (auto item : onlineFriends) ui->friendsList->addItem(item);
-    for (auto item : awayFriends) ui->friendsList->addItem(item);
-    for (auto item : busyFriends) ui->friendsList->addItem(item);
-    for (auto item : offlineFriends) ui->friendsList->addItem(item);
-}
+    friendsModel->applySnapshot(friends);
 
-void MainWindow::updateFriendStatus(int friendId, const QString& status)
-{
-    for(int i = 0; i < ui->friendsList->count(); ++i) {
-        QListWidgetItem* item = ui->friendsList->item(i);
-        if(item->data(Qt::UserRole).toInt() == friendId) {
-            bool hasUnreadMessages = checkUnreadMessages(friendId);
-            item->setIcon(getStatusIcon(status, hasUnreadMessages));
-            break;
+    for (auto it = unreadMessagesMap.cbegin(); it != unreadMessagesMap.cend(); ++it) {
+        if (it.value()) {
+            friendsModel->setUnread(it.key(), true);
         }
     }
 }
 
 QString MainWindow::getFriendStatus(int friendId) const
 {
-    for(int i = 0; i < ui->friendsList->count(); ++i) {
-        QListWidgetItem* item = ui->friendsList->item(i);
-        if(item->data(Qt::UserRole).toInt() == friendId) {
-            return item->data(Qt::UserRole + 1).toString();
-        }
-    }
-    return Protocol::UserStatus::OFFLINE;
+    return friendsModel->statusOf(friendId);
 }
 
-void MainWindow::removeFriend(QListWidgetItem* item)
+void MainWindow::removeFriend(const QModelIndex& index)
 {
-    int friendId = item->data(Qt::UserRole).toInt();
-    QString friendName = item->text();
+    int friendId = index.data(FriendsModel::FriendIdRole).toInt();
+    QString friendName = index.data(Qt::DisplayRole).toString();
 
-    QMessageBox::StandardButton reply = QMessageBox::question(this,
-                                                              "Remove Friend",
-                                                              QString("Are you sure you want to remove %1 from your friends list?").arg(friendName),
-                                                              QMessageBox::Yes | QMessageBox::No);
-
-    if (reply == QMessageBox::Yes) {
-        closeChatWindow(friendId);
-        QJsonObject request = Protocol::MessageStructure::createRemoveFriendRequest(friendId);
-        networkManager.sendMessage(request);
-    }
+    NotificationQueue::getInstance().question(
+        this, "Remove Friend",
+        QString("Are you sure you want to remove %1 from your friends list?").arg(friendName),
+        this, [this, friendId](bool accepted) {
+            if (!accepted) return;
+            closeChatWindow(friendId);
+            QJsonObject request = Protocol::MessageStructure::createRemoveFriendRequest(friendId);
+            networkManager.sendMessage(request);
+        });
 }
 
 // UI update methods
@@ -416,13 +438,8 @@ void MainWindow::updateConnectionStatus(const QString& status)
 
 void MainWindow::updateIconForUser(int userId, const QString& status, bool hasUnread)
 {
-    for(int i = 0; i < ui->friendsList->count(); ++i) {
-        QListWidgetItem* item = ui->friendsList->item(i);
-        if(item->data(Qt::UserRole).toInt() == userId) {
-            item->setIcon(getStatusIcon(status, hasUnread));
-            break;
-        }
-    }
+    friendsModel->setStatus(userId, status);
+    friendsModel->setUnread(userId, hasUnread);
 }
 
 void MainWindow::refreshInvitationsDialog()
@@ -492,13 +509,17 @@ void MainWindow::onDisconnected()
 {
     LOG_WARNING("Disconnected from server");
     updateConnectionStatus("Disconnected from server");
-    ui->friendsList->clear();
+    friendsModel->clear();
+    // Wiadomości z czasu bez połączenia nie trafią do cache historii
+    HistoryPageCache::getInstance().markAllStale();
 }
 
 void MainWindow::onChatWindowClosed(int friendId)
 {
     LOG_DEBUG(QString("Chat window closed for friend ID: %1").arg(friendId));
-    chatWindows.remove(friendId);
+    if (ChatWindow* chatWindow = chatWindows.take(friendId)) {
+        chatWindowPool->release(chatWindow);
+    }
     unreadMessagesMap[friendId] = false;
 }
 
@@ -511,49 +532,6 @@ void MainWindow::onConnectionStatusChanged(const QString& status)
     }
 }
 
-void MainWindow::onMessageReceived(const QJsonObject& json)
-{
-    QString type = json["type"].toString();
-
-    if (type == Protocol::MessageType::SEARCH_USERS_RESPONSE) {
-        handleSearchResponse(json);
-    }
-    else if (type == Protocol::MessageType::FRIEND_REQUEST_RECEIVED) {
-        handleFriendRequest(json);
-    }
-    else if (type == Protocol::MessageType::FRIEND_REQUEST_ACCEPT_RESPONSE) {
-        handleFriendRequestAcceptResponse(json);
-    }
-    else if (type == Protocol::MessageType::FRIEND_REQUEST_REJECT_RESPONSE) {
-        handleFriendRequestRejectResponse(json);
-    }
-    else if (type == Protocol::MessageType::UNREAD_FROM) {
-        handleUnreadMessages(json);
-    }
-    else if (type == Protocol::MessageType::LOGIN_RESPONSE) {
-        handleLoginResponse(json);
-    }
-    else if (type == Protocol::MessageType::LATEST_MESSAGES_RESPONSE) {
-        handleLatestMessages(json);
-    }
-    else if (type == Protocol::MessageType::MESSAGE_RESPONSE) {
-        handleMessageResponse(json);
-    }
-    else if (type == Protocol::MessageType::NEW_MESSAGES) {
-        handleNewMessage(json);
-    }
-    else if (type == Protocol::MessageType::REMOVE_FRIEND_RESPONSE) {
-        handleRemoveFriendResponse(json);
-    }
-    else if (type == Protocol::MessageType::FRIEND_REMOVED) {
-        handleFriendRemoved(json);
-    }
-    else if (type == Protocol::MessageType::FRIENDS_LIST_RESPONSE ||
-             type == Protocol::MessageType::FRIENDS_STATUS_UPDATE) {
-        handleFriendsListUpdate(json);
-    }
-}
-
 void MainWindow::onMenuSearchTriggered()
 {
     if (!searchDialog) {
@@ -569,39 +547,19 @@ void MainWindow::onMenuSearchTriggered()
 
 void MainWindow::showFriendsContextMenu(const QPoint& pos)
 {
-    QListWidgetItem* item = ui->friendsList->itemAt(pos);
-    if (!item) return;
+    QModelIndex index = ui->friendsList->indexAt(pos);
+    if (!index.isValid()) return;
 
     QMenu contextMenu(this);
     QAction* removeFriendAction = contextMenu.addAction("Remove Friend");
     QAction* selectedAction = contextMenu.exec(ui->friendsList->mapToGlobal(pos));
 
     if (selectedAction == removeFriendAction) {
-        removeFriend(item);
+        removeFriend(index);
     }
 }
 
 // Helper methods
-QIcon MainWindow::getStatusIcon(const QString& status, bool hasUnreadMessages) const
-{
-    QString iconPath = ":/resources/icons/status_";
-
-    if (status == Protocol::UserStatus::ONLINE)
-        iconPath += "online";
-    else if (status == Protocol::UserStatus::AWAY)
-        iconPath += "away";
-    else if (status == Protocol::UserStatus::BUSY)
-        iconPath += "busy";
-    else
-        iconPath += "offline";
-
-    if (hasUnreadMessages)
-        iconPath += "_msg";
-
-    iconPath += ".svg";
-    return QIcon(iconPath);
-}
-
 bool MainWindow::checkUnreadMessages(int friendId) const
 {
     return unreadMessagesMap.value(friendId, false);
@@ -611,7 +569,7 @@ void MainWindow::sendLogoutRequest()
 {
     if (networkManager.isConnected()) {
         QJsonObject logoutRequest = Protocol::MessageStructure::createLogoutRequest();
-        networkManager.sendMessage(logoutRequest);
+        networkManager.sendMessage(logoutRequest, NetworkManager::FlushMode::FlushNow);
     }
 }
 
@@ -637,8 +595,6 @@ void MainWindow::onInvitationsActionTriggered()
 {
     if (!invitationsDialog) {
         invitationsDialog = new InvitationsDialog(networkManager, this);
-        connect(&networkManager, &NetworkManager::messageReceived,
-                invitationsDialog, &InvitationsDialog::onMessageReceived);
     }
     invitationsDialog->show();
     invitationsDialog->refreshInvitations();
@@ -646,26 +602,14 @@ void MainWindow::onInvitationsActionTriggered()
 
 bool MainWindow::isFriend(int userId) const
 {
-    LOG_DEBUG(QString("Checking if user ID %1 is in friends list").arg(userId));
-
-    for(int i = 0; i < ui->friendsList->count(); ++i) {
-        QListWidgetItem* item = ui->friendsList->item(i);
-        int itemUserId = item->data(Qt::UserRole).toInt();
-        LOG_DEBUG(QString("Comparing with friend ID: %1").arg(itemUserId));
-
-        if(itemUserId == userId) {
-            LOG_DEBUG(QString("Found user ID %1 in friends list").arg(userId));
-            return true;
-        }
-    }
-
-    LOG_DEBUG(QString("User ID %1 not found in friends list").arg(userId));
-    return false;
+    return friendsModel->contains(userId);
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
 {
-    for (auto chatWindow : chatWindows) {
+    // Zamknięcie okna usuwa je z chatWindows
+    const QList<ChatWindow*> openWindows = chatWindows.values();
+    for (ChatWindow* chatWindow : openWindows) {
         if (chatWindow) {
             chatWindow->close();
         }
@@ -12,11 +12,12 @@
 #include <QTimer>
 #include <QJsonArray>
 #include <QMap>
-#include <qlistwidget.h>
 #include "network/NetworkManager.h"
 #include "config/ConfigManager.h"
 #include "ChatWindow.h"
+#include "ChatWindowPool.h"
 #include "InvitationsDialog.h"
+#include "FriendsModel.h"
 
 class SearchDialog;  // Forward declaration
 
@@ -51,7 +52,6 @@ private slots:
 
     // Network event handlers
     void onConnectionStatusChanged(const QString& status);
-    void onMessageReceived(const QJsonObject& message);
     void onNetworkError(const QString& error);
     void onDisconnected();
     void onChatWindowClosed(int friendId);
@@ -60,6 +60,7 @@ private:
     // Initialization
     void initializeUI();
     void setupNetworkConnections();
+    void setupMessageRoutes();
     void setupInvitationsMenu();
     void setupStatusComboBox();
     void setupUIConnections();
@@ -78,19 +79,19 @@ private:
     void handleRemoveFriendResponse(const QJsonObject& json);
     void handleFriendRemoved(const QJsonObject& json);
     void handleFriendsListUpdate(const QJsonObject& json);
+    void handleFriendsStatusDelta(const QJsonObject& json);
 
     // Chat window management
-    void openChatWindow(QListWidgetItem* item);
+    void openChatWindow(const QModelIndex& index);
     void closeChatWindow(int friendId);
+    ChatWindow* acquireChatWindow(const QString& friendName, int friendId);
     void processChatMessage(const QJsonObject& json, int chatWindowId);
     void handleUnreadMessage(int fromId, const QString& status);
 
     // Friends list management
     void updateFriendsList(const QJsonArray& friends);
-    void sortFriendsListByStatus();
-    void updateFriendStatus(int friendId, const QString& status);
     QString getFriendStatus(int friendId) const;
-    void removeFriend(QListWidgetItem* item);
+    void removeFriend(const QModelIndex& index);
 
     // UI updates
     void updateConnectionStatus(const QString& status);
@@ -98,7 +99,6 @@ private:
     void refreshInvitationsDialog();
 
     // Helper methods
-    QIcon getStatusIcon(const QString& status, bool hasUnreadMessages) const;
     bool checkUnreadMessages(int friendId) const;
     void sendLogoutRequest();
 
@@ -113,7 +113,9 @@ private:
     ConfigManager::ConnectionConfig connectionConfig;
 
     QMap<int, ChatWindow*> chatWindows;
+    ChatWindowPool* chatWindowPool;
     QMap<int, bool> unreadMessagesMap;
+    FriendsModel* friendsModel;
     SearchDialog* searchDialog;
     InvitationsDialog* invitationsDialog;
 
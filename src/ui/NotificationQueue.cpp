@@ -0,0 +1,94 @@
+/**
+ * @file NotificationQueue.cpp
+ * @brief Non-blocking queue of user notifications and prompts implementation
+ * @author piotrek-pl
+ * @date 2025-02-09 15:47:30
+ */
+
+#include "NotificationQueue.h"
+
+NotificationQueue& NotificationQueue::getInstance()
+{
+    static NotificationQueue instance;
+    return instance;
+}
+
+void NotificationQueue::information(QWidget* parent, const QString& title, const QString& text)
+{
+    enqueue(Notification{parent, QMessageBox::Information, title, text, false, nullptr, nullptr});
+}
+
+void NotificationQueue::warning(QWidget* parent, const QString& title, const QString& text)
+{
+    enqueue(Notification{parent, QMessageBox::Warning, title, text, false, nullptr, nullptr});
+}
+
+void NotificationQueue::question(QWidget* parent, const QString& title, const QString& text,
+                                 QObject* context, Answer onAnswer)
+{
+    enqueue(Notification{parent, QMessageBox::Question, title, text, true, context, std::move(onAnswer)});
+}
+
+void NotificationQueue::enqueue(Notification notification)
+{
+    queue.enqueue(std::move(notification));
+    if (!active) {
+        showNext();
+    }
+}
+
+void NotificationQueue::showNext()
+{
+    while (!queue.isEmpty()) {
+        current = queue.dequeue();
+        // Okno, którego dotyczył komunikat, zostało już zamknięte
+        if (current.prompt && !current.context) continue;
+
+        QMessageBox* box = new QMessageBox(current.icon, current.title, current.text,
+                                           current.prompt ? QMessageBox::Yes | QMessageBox::No
+                                                          : QMessageBox::Ok,
+                                           current.parent);
+        box->setAttribute(Qt::WA_DeleteOnClose);
+        if (current.prompt) {
+            box->setDefaultButton(QMessageBox::Yes);
+            box->setEscapeButton(QMessageBox::No);
+        }
+        connect(box, &QMessageBox::finished, this, [this, box]() { onFinished(box); });
+        // Rodzic usunięty razem z otwartym oknem - przechodzimy do następnego
+        connect(box, &QObject::destroyed, this, [this]() {
+            QMetaObject::invokeMethod(this, [this]() {
+                if (!active) showNext();
+            }, Qt::QueuedConnection);
+        });
+
+        active = box;
+        // open() zamiast exec() - bez zagnieżdżonej pętli zdarzeń
+        box->open();
+        return;
+    }
+}
+
+void NotificationQueue::onFinished(QMessageBox* box)
+{
+    if (box != active) return;
+
+    const bool accepted = box->standardButton(box->clickedButton()) == QMessageBox::Yes;
+    Notification answered = std::move(current);
+    current = Notification{};
+    active = nullptr;
+
+    if (answered.prompt && answered.context && answered.onAnswer) {
+        answered.onAnswer(accepted);
+    }
+    showNext();
+}
+
+void NotificationQueue::clear()
+{
+    queue.clear();
+    current = Notification{};
+    if (QMessageBox* box = active) {
+        active = nullptr;
+        box->close();
+    }
+}
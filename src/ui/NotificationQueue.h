@@ -0,0 +1,63 @@
+/**
+ * @file NotificationQueue.h
+ * @brief Non-blocking queue of user notifications and prompts definition
+ * @author piotrek-pl
+ * @date 2025-02-09 15:47:30
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QMessageBox>
+#include <functional>
+
+/**
+ * Shows message boxes one at a time without QMessageBox::exec(), so network
+ * handlers return immediately instead of spinning a nested event loop.
+ * A prompt's answer is delivered later through a callback from the main
+ * event loop; it is dropped if the context object is gone by then.
+ */
+class NotificationQueue : public QObject {
+    Q_OBJECT
+
+public:
+    using Answer = std::function<void(bool accepted)>;
+
+    static NotificationQueue& getInstance();
+
+    void information(QWidget* parent, const QString& title, const QString& text);
+    void warning(QWidget* parent, const QString& title, const QString& text);
+    // Pytanie Tak/Nie; odpowiedź trafia do onAnswer, o ile context jeszcze istnieje
+    void question(QWidget* parent, const QString& title, const QString& text,
+                  QObject* context, Answer onAnswer);
+
+    // Aktualnie wyświetlane okno (nullptr, gdy kolejka jest pusta)
+    QMessageBox* activeBox() const { return active; }
+    int pendingCount() const { return queue.size(); }
+    void clear();
+
+private:
+    NotificationQueue() = default;
+    NotificationQueue(const NotificationQueue&) = delete;
+    NotificationQueue& operator=(const NotificationQueue&) = delete;
+
+    struct Notification {
+        QPointer<QWidget> parent;
+        QMessageBox::Icon icon;
+        QString title;
+        QString text;
+        bool prompt;
+        QPointer<QObject> context;
+        Answer onAnswer;
+    };
+
+    void enqueue(Notification notification);
+    void showNext();
+    void onFinished(QMessageBox* box);
+
+    QQueue<Notification> queue;
+    QPointer<QMessageBox> active;
+    Notification current;
+};
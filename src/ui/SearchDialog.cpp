@@ -9,7 +9,7 @@
 #include "ui_SearchDialog.h"
 #include "MainWindow.h"
 #include <QMenu>
-#include <QMessageBox>
+#include "NotificationQueue.h"
 #include "network/Protocol.h"
 #include "utils/Logger.h"
 
@@ -18,7 +18,14 @@ SearchDialog::SearchDialog(NetworkManager& networkManager, MainWindow* parent)
     , ui(new Ui::SearchDialog)
     , networkManager(networkManager)
     , mainWindow(parent)
+    , resultCache(CACHE_CAPACITY, CACHE_TTL_MS)
+    , requestSentAt(0)
+    , nextSearchId(1)
+    , inFlightSearchId(0)
+    , droppedResponses(0)
+    , averageRoundTripMs(0.0)
 {
+    clock.start();
     initializeUI();
     setupSearchTimer();
     setupConnections();
@@ -41,14 +48,16 @@ void SearchDialog::setupSearchTimer()
 {
     searchTimer = new QTimer(this);
     searchTimer->setSingleShot(true);
-    searchTimer->setInterval(500);
+    searchTimer->setInterval(INITIAL_SEARCH_DELAY_MS);
     connect(searchTimer, &QTimer::timeout, this, &SearchDialog::performSearch);
 }
 
 void SearchDialog::setupConnections()
 {
-    connect(&networkManager, &NetworkManager::messageReceived,
-            this, &SearchDialog::handleServerResponse);
+    networkManager.router().subscribe(this, Protocol::MessageType::Id::ADD_FRIEND_RESPONSE,
+                                      [this](const QJsonObject& json) { handleAddFriendResponse(json); });
+    networkManager.router().subscribe(this, Protocol::MessageType::Id::INVITATION_ALREADY_EXISTS,
+                                      [this](const QJsonObject& json) { handleInvitationExistsResponse(json); });
     connect(ui->searchEdit, &QLineEdit::textChanged,
             this, &SearchDialog::onSearchTextChanged);
     connect(ui->resultsList, &QWidget::customContextMenuRequested,
@@ -59,25 +68,43 @@ void SearchDialog::updatePendingInvitations(const QSet<int>& userIds)
 {
     LOG_DEBUG(QString("Updating pending invitations list with %1 users").arg(userIds.size()));
     pendingInvitations = userIds;
-    if (!lastSearchResponse.isEmpty()) {
-        onSearchResponse(lastSearchResponse);
-    }
+    renderResults(lastResults);
 }
 
 void SearchDialog::onInvitationStatusChanged(int userId)
 {
     LOG_DEBUG(QString("Invitation status changed for user ID: %1").arg(userId));
     pendingInvitations.remove(userId);
-    if (!lastSearchResponse.isEmpty()) {
-        onSearchResponse(lastSearchResponse);
-    }
+    renderResults(lastResults);
 }
 
 void SearchDialog::onSearchResponse(const QJsonObject& response)
 {
-    lastSearchResponse = response;
-    ui->resultsList->clear();
+    // Odpowiedź na zapytanie zastąpione nowszym odrzucamy przed budowaniem listy.
+    // Serwer bez search_id: aktualna jest tylko odpowiedź na zapytanie w toku.
+    const qint64 searchId = response["search_id"].toInteger();
+    if (inFlightQuery.isEmpty() || (searchId != 0 && searchId != inFlightSearchId)) {
+        ++droppedResponses;
+        LOG_DEBUG(QString("Dropping stale search response (search_id %1, current %2)")
+                      .arg(searchId).arg(inFlightSearchId));
+        return;
+    }
+
     QJsonArray users = response["users"].toArray();
+    updateSearchInterval(clock.elapsed() - requestSentAt);
+    // Bez has_more serwer zwraca pełny zbiór wyników
+    resultCache.insert(inFlightQuery, users, !response["has_more"].toBool(), clock.elapsed());
+    inFlightQuery.clear();
+    inFlightSearchId = 0;
+
+    renderResults(users);
+    LOG_INFO(QString("Received search results: %1 users found").arg(users.size()));
+}
+
+void SearchDialog::renderResults(const QJsonArray& users)
+{
+    lastResults = users;
+    ui->resultsList->clear();
 
     for (const QJsonValue& userVal : users) {
         QJsonObject user = userVal.toObject();
@@ -100,8 +127,31 @@ void SearchDialog::onSearchResponse(const QJsonObject& response)
 
         ui->resultsList->addItem(item);
     }
+}
 
-    LOG_INFO(QString("Received search results: %1 users found").arg(users.size()));
+bool SearchDialog::showCachedResults(const QString& query)
+{
+    const qint64 now = clock.elapsed();
+    std::optional<QJsonArray> users = resultCache.lookup(query, now);
+    if (!users) {
+        users = resultCache.narrow(query, now);
+    }
+    if (!users) return false;
+
+    LOG_DEBUG(QString("Search for '%1' answered from cache: %2 users").arg(query).arg(users->size()));
+    renderResults(*users);
+    return true;
+}
+
+void SearchDialog::updateSearchInterval(qint64 roundTripMs)
+{
+    averageRoundTripMs = averageRoundTripMs > 0.0
+        ? 0.8 * averageRoundTripMs + 0.2 * static_cast<double>(roundTripMs)
+        : static_cast<double>(roundTripMs);
+
+    // Przy szybkim serwerze krótkie opóźnienie, przy wolnym mniej zbędnych zapytań
+    const int interval = qBound(MIN_SEARCH_DELAY_MS, qRound(2.0 * averageRoundTripMs), MAX_SEARCH_DELAY_MS);
+    searchTimer->setInterval(interval);
 }
 
 void SearchDialog::createContextMenuForFriend(QMenu& menu, const QString& username)
@@ -164,13 +214,13 @@ void SearchDialog::handleAddFriendResponse(const QJsonObject& response)
     QString message = response["message"].toString();
 
     if (success) {
-        QMessageBox::information(this, "Success",
-                                 "Friend request sent successfully!");
+        NotificationQueue::getInstance().information(this, "Success",
+                                                     "Friend request sent successfully!");
         LOG_INFO("Friend request sent successfully");
         emit friendRequestSent();
     } else {
-        QMessageBox::warning(this, "Error",
-                             "Failed to send friend request. " + message);
+        NotificationQueue::getInstance().warning(this, "Error",
+                                                 "Failed to send friend request. " + message);
         LOG_WARNING(QString("Failed to send friend request: %1").arg(message));
     }
 }
@@ -180,37 +230,30 @@ void SearchDialog::handleInvitationExistsResponse(const QJsonObject& response)
     int userId = response["user_id"].toInt();
     QString username = response["username"].toString();
 
-    QMessageBox::warning(this, "Warning",
-                         "You have already sent an invitation to this user.");
+    NotificationQueue::getInstance().warning(this, "Warning",
+                                             "You have already sent an invitation to this user.");
     LOG_WARNING(QString("Attempted to send duplicate invitation to user %1 (ID: %2)")
                     .arg(username).arg(userId));
 
     pendingInvitations.insert(userId);
-
-    if (!lastSearchResponse.isEmpty()) {
-        onSearchResponse(lastSearchResponse);
-    }
-}
-
-void SearchDialog::handleServerResponse(const QJsonObject& response)
-{
-    QString type = response["type"].toString();
-
-    if (type == Protocol::MessageType::ADD_FRIEND_RESPONSE) {
-        handleAddFriendResponse(response);
-    }
-    else if (type == Protocol::MessageType::INVITATION_ALREADY_EXISTS) {
-        handleInvitationExistsResponse(response);
-    }
+    renderResults(lastResults);
 }
 
 void SearchDialog::onSearchTextChanged(const QString& text)
 {
     if (text.length() >= 3) {
+        // Znany wynik lub zawężenie kompletnego wyniku - bez zapytania do serwera
+        if (showCachedResults(text)) {
+            searchTimer->stop();
+            cancelInFlightSearch();
+            return;
+        }
         searchTimer->start();
-        LOG_DEBUG(QString("Search timer started for query: %1").arg(text));
+        LOG_DEBUG(QString("Search timer started for query: %1 (%2 ms)").arg(text).arg(searchTimer->interval()));
     } else {
-        ui->resultsList->clear();
+        searchTimer->stop();
+        cancelInFlightSearch();
+        renderResults(QJsonArray());
     }
 }
 
@@ -218,12 +261,29 @@ void SearchDialog::performSearch()
 {
     QString query = ui->searchEdit->text();
     if (query.length() >= 3) {
-        QJsonObject searchRequest = Protocol::MessageStructure::createSearchUsersRequest(query);
+        // Nowe zapytanie zastępuje poprzednie, niezależnie od źródła wyniku
+        cancelInFlightSearch();
+        if (showCachedResults(query)) return;
+
+        inFlightSearchId = nextSearchId++;
+        QJsonObject searchRequest = Protocol::MessageStructure::createSearchUsersRequest(query, inFlightSearchId);
         networkManager.sendMessage(searchRequest);
+        inFlightQuery = query;
+        requestSentAt = clock.elapsed();
         LOG_DEBUG(QString("Sending search request for query: %1").arg(query));
     }
 }
 
+void SearchDialog::cancelInFlightSearch()
+{
+    if (inFlightSearchId == 0) return;
+
+    networkManager.sendMessage(Protocol::MessageStructure::createSearchUsersCancel(inFlightSearchId));
+    LOG_DEBUG(QString("Cancelled search %1 for query: %2").arg(inFlightSearchId).arg(inFlightQuery));
+    inFlightSearchId = 0;
+    inFlightQuery.clear();
+}
+
 void SearchDialog::sendFriendRequest(int userId, const QString& username)
 {
     LOG_INFO(QString("Sending friend request to user %1 (ID: %2)").arg(username).arg(userId));
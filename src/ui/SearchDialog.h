@@ -11,7 +11,9 @@
 #include <QDialog>
 #include <QTimer>
 #include <QSet>
+#include <QElapsedTimer>
 #include "network/NetworkManager.h"
+#include "SearchResultCache.h"
 
 namespace Ui {
 class SearchDialog;
@@ -27,6 +29,9 @@ public:
     explicit SearchDialog(NetworkManager& networkManager, MainWindow* parent = nullptr);
     ~SearchDialog();
 
+    // Odpowiedzi odrzucone jako nieaktualne
+    quint64 staleResponses() const { return droppedResponses; }
+
 signals:
     void friendRequestSent();
 
@@ -39,7 +44,6 @@ private slots:
     void onSearchTextChanged(const QString& text);
     void performSearch();
     void showContextMenu(const QPoint& pos);
-    void handleServerResponse(const QJsonObject& response);
 
 private:
     // Initialization methods
@@ -58,6 +62,10 @@ private:
 
     // Helper methods
     void sendFriendRequest(int userId, const QString& username);
+    void renderResults(const QJsonArray& users);
+    bool showCachedResults(const QString& query);
+    void updateSearchInterval(qint64 roundTripMs);
+    void cancelInFlightSearch();
 
 private:
     Ui::SearchDialog *ui;
@@ -65,7 +73,23 @@ private:
     MainWindow* mainWindow;
     QTimer* searchTimer;
     QSet<int> pendingInvitations;
-    QJsonObject lastSearchResponse;
+    QJsonArray lastResults;
+
+    // Cache wyników i opóźnienie wyszukiwania dopasowane do RTT serwera
+    static constexpr int CACHE_CAPACITY = 32;
+    static constexpr qint64 CACHE_TTL_MS = 30000;
+    static constexpr int MIN_SEARCH_DELAY_MS = 150;
+    static constexpr int MAX_SEARCH_DELAY_MS = 800;
+    static constexpr int INITIAL_SEARCH_DELAY_MS = 500;
+
+    SearchResultCache resultCache;
+    QElapsedTimer clock;
+    QString inFlightQuery;
+    qint64 nextSearchId;
+    qint64 inFlightSearchId;   // 0 - brak zapytania w toku
+    quint64 droppedResponses;
+    qint64 requestSentAt;
+    double averageRoundTripMs;  // Średnia wykładnicza, 0 - brak pomiaru
 };
 
 #endif // SEARCHDIALOG_H
@@ -0,0 +1,88 @@
+/**
+ * @file SearchResultCache.cpp
+ * @brief LRU cache of user search results implementation
+ * @author piotrek-pl
+ * @date 2025-02-09 09:26:14
+ */
+
+#include "SearchResultCache.h"
+
+SearchResultCache::SearchResultCache(int capacity, qint64 ttlMs)
+    : capacity(qMax(1, capacity))
+    , ttlMs(ttlMs)
+{
+}
+
+bool SearchResultCache::matches(const QJsonObject& user, const QString& query)
+{
+    return user["username"].toString().contains(query.trimmed(), Qt::CaseInsensitive);
+}
+
+SearchResultCache::Entry* SearchResultCache::find(const QString& key, qint64 now)
+{
+    auto it = entries.find(key);
+    if (it == entries.end()) return nullptr;
+
+    if (now - it->storedAt > ttlMs) {
+        recency.erase(it->position);
+        entries.erase(it);
+        return nullptr;
+    }
+
+    // Przeniesienie na koniec listy - ostatnio używany
+    recency.splice(recency.end(), recency, it->position);
+    return &it.value();
+}
+
+void SearchResultCache::insert(const QString& query, const QJsonArray& users, bool complete, qint64 now)
+{
+    const QString key = normalize(query);
+
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        recency.erase(it->position);
+        entries.erase(it);
+    }
+
+    while (entries.size() >= capacity) {
+        entries.remove(recency.front());
+        recency.pop_front();
+    }
+
+    recency.push_back(key);
+    entries.insert(key, Entry{users, complete, now, std::prev(recency.end())});
+}
+
+std::optional<QJsonArray> SearchResultCache::lookup(const QString& query, qint64 now)
+{
+    Entry* entry = find(normalize(query), now);
+    if (!entry) return std::nullopt;
+    return entry->users;
+}
+
+std::optional<QJsonArray> SearchResultCache::narrow(const QString& query, qint64 now)
+{
+    const QString key = normalize(query);
+
+    // Najdłuższy prefiks z kompletnym wynikiem
+    for (qsizetype length = key.size() - 1; length > 0; --length) {
+        Entry* entry = find(key.left(length), now);
+        if (!entry || !entry->complete) continue;
+
+        QJsonArray narrowed;
+        for (const QJsonValue& user : entry->users) {
+            if (matches(user.toObject(), key)) {
+                narrowed.append(user);
+            }
+        }
+        insert(key, narrowed, true, entry->storedAt);
+        return narrowed;
+    }
+    return std::nullopt;
+}
+
+void SearchResultCache::clear()
+{
+    entries.clear();
+    recency.clear();
+}
@@ -0,0 +1,55 @@
+/**
+ * @file SearchResultCache.h
+ * @brief LRU cache of user search results definition
+ * @author piotrek-pl
+ * @date 2025-02-09 09:26:14
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <list>
+#include <optional>
+
+/**
+ * Query -> search_users result set, bounded by entry count and age.
+ * Matching assumes the server does a case-insensitive substring match on
+ * the username, so a complete result set for "abc" also contains every
+ * result for "abcd" and can be narrowed locally.
+ */
+class SearchResultCache {
+public:
+    SearchResultCache(int capacity, qint64 ttlMs);
+
+    // complete == false: serwer obciął wyniki, nie nadają się do zawężania
+    void insert(const QString& query, const QJsonArray& users, bool complete, qint64 now);
+
+    // Wynik dla dokładnie tego zapytania
+    std::optional<QJsonArray> lookup(const QString& query, qint64 now);
+    // Wynik zawężony lokalnie z kompletnego wyniku dla krótszego prefiksu zapytania
+    std::optional<QJsonArray> narrow(const QString& query, qint64 now);
+
+    void clear();
+    int size() const { return entries.size(); }
+
+    static bool matches(const QJsonObject& user, const QString& query);
+
+private:
+    struct Entry {
+        QJsonArray users;
+        bool complete;
+        qint64 storedAt;
+        std::list<QString>::iterator position;
+    };
+
+    static QString normalize(const QString& query) { return query.trimmed().toLower(); }
+    Entry* find(const QString& key, qint64 now);
+
+    int capacity;
+    qint64 ttlMs;
+    QHash<QString, Entry> entries;
+    std::list<QString> recency;  // Od najdawniej używanego
+};
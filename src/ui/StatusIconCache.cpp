@@ -0,0 +1,89 @@
+/**
+ * @file StatusIconCache.cpp
+ * @brief Process-wide cache of pre-rendered status icons
+ * @author piotrek-pl
+ * @date 2025-02-07 15:38:21
+ */
+
+#include "StatusIconCache.h"
+#include <QPainter>
+#include <QSvgRenderer>
+#include <QtMath>
+
+StatusIconCache& StatusIconCache::getInstance()
+{
+    static StatusIconCache instance;
+    return instance;
+}
+
+QString StatusIconCache::resourcePath(FriendsModel::Status status, bool unread)
+{
+    return QString(":/resources/icons/status_%1%2.svg")
+        .arg(FriendsModel::statusToString(status), unread ? "_msg" : "");
+}
+
+int StatusIconCache::variantOf(FriendsModel::Status status, bool unread)
+{
+    return static_cast<int>(status) * 2 + (unread ? 1 : 0);
+}
+
+quint64 StatusIconCache::keyOf(int variant, int size, qreal devicePixelRatio)
+{
+    const quint64 ratio = static_cast<quint64>(qRound(devicePixelRatio * 100));
+    return (ratio << 32) | (static_cast<quint64>(size) << 8) | static_cast<quint64>(variant);
+}
+
+QPixmap StatusIconCache::render(int variant, int size, qreal devicePixelRatio) const
+{
+    const auto status = static_cast<FriendsModel::Status>(variant / 2);
+    const int pixelSize = qCeil(size * devicePixelRatio);
+
+    QPixmap pixmap(pixelSize, pixelSize);
+    pixmap.fill(Qt::transparent);
+
+    QSvgRenderer renderer(resourcePath(status, variant % 2 == 1));
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+    renderer.render(&painter);
+    painter.end();
+
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    return pixmap;
+}
+
+void StatusIconCache::warmUp(const QList<int>& sizes, qreal devicePixelRatio)
+{
+    for (int variant = 0; variant < VARIANT_COUNT; ++variant) {
+        QIcon icon;
+        for (int size : sizes) {
+            const auto status = static_cast<FriendsModel::Status>(variant / 2);
+            icon.addPixmap(pixmap(status, variant % 2 == 1, size, devicePixelRatio));
+        }
+        icons[variant] = icon;
+    }
+}
+
+QPixmap StatusIconCache::pixmap(FriendsModel::Status status, bool unread, int size, qreal devicePixelRatio)
+{
+    const int variant = variantOf(status, unread);
+    const quint64 key = keyOf(variant, size, devicePixelRatio);
+
+    auto it = pixmaps.constFind(key);
+    if (it != pixmaps.constEnd()) {
+        return *it;
+    }
+
+    QPixmap rendered = render(variant, size, devicePixelRatio);
+    pixmaps.insert(key, rendered);
+    return rendered;
+}
+
+QIcon StatusIconCache::icon(FriendsModel::Status status, bool unread)
+{
+    QIcon& cached = icons[variantOf(status, unread)];
+    if (cached.isNull()) {
+        // Bez warmUp() - ikona SVG, rasteryzowana przez QIcon przy pierwszym użyciu
+        cached = QIcon(resourcePath(status, unread));
+    }
+    return cached;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file StatusIconCache.h
+ * @brief Process-wide cache of pre-rendered status icons
+ * @author piotrek-pl
+ * @date 2025-02-07 15:38:21
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QIcon>
+#include <QPixmap>
+#include <QString>
+#include "FriendsModel.h"
+
+/**
+ * Rasterizes every status_*.svg variant once per (size, device pixel ratio)
+ * and hands out shared pixmaps / icons built from them. Used only from the
+ * GUI thread.
+ */
+class StatusIconCache {
+public:
+    static StatusIconCache& getInstance();
+
+    // Wstępne renderowanie wszystkich wariantów dla podanych rozmiarów
+    void warmUp(const QList<int>& sizes, qreal devicePixelRatio);
+
+    QPixmap pixmap(FriendsModel::Status status, bool unread, int size, qreal devicePixelRatio);
+    QIcon icon(FriendsModel::Status status, bool unread);
+
+    static QString resourcePath(FriendsModel::Status status, bool unread);
+
+    int renderedCount() const { return pixmaps.size(); }
+
+private:
+    StatusIconCache() = default;
+    StatusIconCache(const StatusIconCache&) = delete;
+    StatusIconCache& operator=(const StatusIconCache&) = delete;
+
+    static constexpr int VARIANT_COUNT = FriendsModel::STATUS_COUNT * 2;
+
+    static int variantOf(FriendsModel::Status status, bool unread);
+    static quint64 keyOf(int variant, int size, qreal devicePixelRatio);
+    QPixmap render(int variant, int size, qreal devicePixelRatio) const;
+
+    QHash<quint64, QPixmap> pixmaps;
+    QIcon icons[VARIANT_COUNT];
+};
@@ -9,13 +9,32 @@
 #include "config/ConfigManager.h"
 #include <QDateTime>
 #include <QDir>
+#include <QMutexLocker>
 
-Logger::Logger() : currentLevel(LogLevel::INFO) {
+Logger::Logger()
+    : currentLevel(LogLevel::INFO)
+    , fileSize(0)
+    , asyncMode(false)
+    , overflowPolicy(OverflowPolicy::Drop)
+    , flushIntervalMs(50)
+    , writerRunning(false)
+    , stopping(false)
+    , enqueued(0)
+    , written(0)
+    , dropped(0)
+    , blocked(0)
+    , reportedDrops(0)
+{
     initializeFromConfig();
+    if (asyncMode) {
+        startWriter();
+    }
 }
 
 Logger::~Logger() {
-    if (logStream) logStream->flush();
+    stopWriter();
+    QMutexLocker locker(&mutex);
+    if (logFile) logFile->flush();
 }
 
 Logger& Logger::getInstance() {
@@ -31,6 +50,14 @@ void Logger::initializeFromConfig() {
     maxFileSize = logConfig.maxFileSize;
     maxBackupCount = logConfig.maxBackupCount;
     currentLevel = parseLogLevel(logConfig.level);
+
+    asyncMode = logConfig.async;
+    overflowPolicy = logConfig.overflowPolicy == "block" ? OverflowPolicy::Block
+                                                         : OverflowPolicy::Drop;
+    flushIntervalMs = qMax(1, logConfig.flushIntervalMs);
+    if (asyncMode) {
+        queue = std::make_unique<MpscRingBuffer<QString>>(qMax(2, logConfig.queueCapacity));
+    }
 }
 
 LogLevel Logger::parseLogLevel(const QString& levelStr) {
@@ -52,15 +79,22 @@ void Logger::ensureDirectoryExists(const QString& filename) {
 
 bool Logger::openLogFile(const QString& filename) {
     logFile = std::make_unique<QFile>(filename);
+    fileSize = 0;
     if (!logFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
         qWarning() << "Failed to open log file:" << filename;
+        logFile.reset();
         return false;
     }
-    logStream = std::make_unique<QTextStream>(logFile.get());
+    fileSize = logFile->size();
     return true;
 }
 
 void Logger::setLogFile(const QString& filename) {
+    // Wpisy sprzed zmiany trafiają jeszcze do poprzedniego pliku
+    flush();
+
+    QMutexLocker locker(&mutex);
+    closeCurrentFile();
     ensureDirectoryExists(filename);
     openLogFile(filename);
 }
@@ -74,27 +108,140 @@ QString Logger::createLogEntry(LogLevel level, const QString& message) {
 }
 
 void Logger::writeLogEntry(const QString& entry) {
-    if (logStream) {
-        *logStream << entry;
-        logStream->flush();
+    const QByteArray data = entry.toUtf8();
+    if (logFile) {
+        logFile->write(data);
+        fileSize += data.size();
     }
-    fprintf(stderr, "%s", entry.toUtf8().constData());
+    fwrite(data.constData(), 1, static_cast<size_t>(data.size()), stderr);
 }
 
 void Logger::checkFileSize() {
-    if (logFile && logFile->size() > maxFileSize) {
+    if (logFile && fileSize > maxFileSize) {
         rotateLogFile();
     }
 }
 
 void Logger::log(LogLevel level, const QString& message) {
-    if (level < currentLevel) return;
+    if (!isEnabled(level)) return;
 
     QString logEntry = createLogEntry(level, message);
+    if (writerRunning) {
+        enqueue(level, std::move(logEntry));
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
     writeLogEntry(logEntry);
+    if (logFile) logFile->flush();
     checkFileSize();
 }
 
+void Logger::enqueue(LogLevel level, QString&& entry) {
+    if (!queue->push(std::move(entry))) {
+        if (overflowPolicy == OverflowPolicy::Drop) {
+            ++dropped;
+            return;
+        }
+
+        ++blocked;
+        do {
+            wakeWriter.wakeOne();
+            QThread::yieldCurrentThread();
+        } while (!queue->push(std::move(entry)));
+    }
+    ++enqueued;
+
+    // Błędy i zapełniona kolejka budzą wątek zapisu przed upływem interwału
+    if (level >= LogLevel::ERROR || queue->approximateSize() >= queue->capacity() / 2) {
+        wakeWriter.wakeOne();
+    }
+}
+
+void Logger::startWriter() {
+    stopping = false;
+    writerThread.reset(QThread::create([this]() { writerLoop(); }));
+    writerThread->setObjectName("LoggerWriter");
+    writerRunning = true;
+    writerThread->start(QThread::LowPriority);
+}
+
+void Logger::stopWriter() {
+    if (!writerThread) return;
+
+    {
+        QMutexLocker locker(&wakeMutex);
+        stopping = true;
+        wakeWriter.wakeAll();
+    }
+    writerThread->wait();
+    writerThread.reset();
+    writerRunning = false;
+
+    // Wpisy dodane w trakcie zatrzymywania
+    drainQueue();
+}
+
+void Logger::writerLoop() {
+    while (true) {
+        {
+            QMutexLocker locker(&wakeMutex);
+            if (!stopping && queue->approximateSize() == 0) {
+                wakeWriter.wait(&wakeMutex, static_cast<unsigned long>(flushIntervalMs));
+            }
+        }
+
+        const bool stop = stopping;
+        drainQueue();
+        if (stop) break;
+    }
+}
+
+void Logger::drainQueue() {
+    quint64 count = 0;
+    {
+        QMutexLocker locker(&mutex);
+        QString entry;
+        while (queue->pop(entry)) {
+            writeLogEntry(entry);
+            checkFileSize();
+            ++count;
+        }
+
+        const quint64 totalDropped = dropped.load();
+        if (totalDropped != reportedDrops) {
+            writeLogEntry(createLogEntry(LogLevel::WARNING,
+                                         QString("Log queue overflow: %1 records dropped")
+                                             .arg(totalDropped - reportedDrops)));
+            reportedDrops = totalDropped;
+        }
+
+        // Jeden flush na partię zamiast na każdą linię
+        if (logFile) logFile->flush();
+    }
+
+    if (count > 0) {
+        QMutexLocker locker(&wakeMutex);
+        written += count;
+        drained.wakeAll();
+    }
+}
+
+void Logger::flush() {
+    if (!writerRunning) {
+        QMutexLocker locker(&mutex);
+        if (logFile) logFile->flush();
+        return;
+    }
+
+    const quint64 target = enqueued.load();
+    QMutexLocker locker(&wakeMutex);
+    while (written.load() < target && writerRunning) {
+        wakeWriter.wakeOne();
+        drained.wait(&wakeMutex, 100);
+    }
+}
+
 void Logger::removeOldestLog(const QString& baseFilename) {
     QString oldestLog = QString("%1.%2").arg(baseFilename).arg(maxBackupCount);
     QFile::remove(oldestLog);
@@ -110,14 +257,13 @@ void Logger::rotateExistingLogs(const QString& baseFilename) {
 
 void Logger::createNewLogFile(const QString& baseFilename) {
     QFile::rename(baseFilename, baseFilename + ".1");
-    setLogFile(baseFilename);
+    ensureDirectoryExists(baseFilename);
+    openLogFile(baseFilename);
 }
 
 void Logger::closeCurrentFile() {
-    if (logStream) {
-        logStream->flush();
-    }
     if (logFile) {
+        logFile->flush();
         logFile->close();
     }
 }
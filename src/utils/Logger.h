@@ -10,9 +10,13 @@
 #include <QObject>
 #include <QString>
 #include <QFile>
-#include <QTextStream>
 #include <QDateTime>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <atomic>
 #include <memory>
+#include "MpscRingBuffer.h"
 
 enum class LogLevel {
     DEBUG,
@@ -22,16 +26,37 @@ enum class LogLevel {
     CRITICAL
 };
 
+// Poziomy poniżej tego progu są usuwane z kodu w czasie kompilacji
+// (wartość liczbowa LogLevel, np. 1 = INFO)
+#ifndef JUPITER_LOG_MIN_LEVEL
+#define JUPITER_LOG_MIN_LEVEL 0
+#endif
+
 class Logger : public QObject {
     Q_OBJECT
 
 public:
+    // Zachowanie przy pełnej kolejce w trybie asynchronicznym
+    enum class OverflowPolicy {
+        Drop,
+        Block
+    };
+
     static Logger& getInstance();
 
     void log(LogLevel level, const QString& message);
-    void setLogLevel(LogLevel level) { currentLevel = level; }
+    void setLogLevel(LogLevel level) { currentLevel.store(level, std::memory_order_relaxed); }
+    LogLevel logLevel() const { return currentLevel.load(std::memory_order_relaxed); }
+    bool isEnabled(LogLevel level) const { return level >= currentLevel.load(std::memory_order_relaxed); }
     void setLogFile(const QString& filename);
 
+    // Czeka, aż wszystkie wcześniejsze wpisy trafią do pliku
+    void flush();
+
+    bool isAsync() const { return asyncMode; }
+    quint64 droppedRecords() const { return dropped.load(); }
+    quint64 blockedRecords() const { return blocked.load(); }
+
     // Convenience methods
     void debug(const QString& message) { log(LogLevel::DEBUG, message); }
     void info(const QString& message) { log(LogLevel::INFO, message); }
@@ -56,6 +81,13 @@ private:
     void writeLogEntry(const QString& entry);
     void checkFileSize();
 
+    // Async backend
+    void startWriter();
+    void stopWriter();
+    void enqueue(LogLevel level, QString&& entry);
+    void writerLoop();
+    void drainQueue();
+
     // File rotation
     void removeOldestLog(const QString& baseFilename);
     void rotateExistingLogs(const QString& baseFilename);
@@ -67,15 +99,42 @@ private:
     void initializeFromConfig();
 
     std::unique_ptr<QFile> logFile;
-    std::unique_ptr<QTextStream> logStream;
-    LogLevel currentLevel;
+    std::atomic<LogLevel> currentLevel;
     qint64 maxFileSize;
     int maxBackupCount;
+    qint64 fileSize;  // Licznik bajtów zamiast QFile::size() po każdej linii
+    QMutex mutex;  // Chroni plik; w trybie async używany głównie przez wątek zapisu
+
+    // Tryb asynchroniczny: producenci -> kolejka -> wątek zapisu
+    bool asyncMode;
+    OverflowPolicy overflowPolicy;
+    int flushIntervalMs;
+    std::unique_ptr<MpscRingBuffer<QString>> queue;
+    std::unique_ptr<QThread> writerThread;
+    std::atomic<bool> writerRunning;
+    std::atomic<bool> stopping;
+    std::atomic<quint64> enqueued;
+    std::atomic<quint64> written;
+    std::atomic<quint64> dropped;
+    std::atomic<quint64> blocked;
+    quint64 reportedDrops;  // Tylko wątek zapisu
+    QMutex wakeMutex;
+    QWaitCondition wakeWriter;
+    QWaitCondition drained;
 };
 
-// Makra dla łatwiejszego logowania
-#define LOG_DEBUG(msg) Logger::getInstance().debug(msg)
-#define LOG_INFO(msg) Logger::getInstance().info(msg)
-#define LOG_WARNING(msg) Logger::getInstance().warning(msg)
-#define LOG_ERROR(msg) Logger::getInstance().error(msg)
-#define LOG_CRITICAL(msg) Logger::getInstance().critical(msg)
+// Makra dla łatwiejszego logowania - argument jest budowany dopiero
+// po sprawdzeniu poziomu, więc wyłączone wywołania nic nie alokują
+#define JUPITER_LOG(level, msg)                                              \
+    do {                                                                     \
+        if (static_cast<int>(level) >= JUPITER_LOG_MIN_LEVEL &&              \
+            Logger::getInstance().isEnabled(level)) {                        \
+            Logger::getInstance().log(level, msg);                           \
+        }                                                                    \
+    } while (0)
+
+#define LOG_DEBUG(msg) JUPITER_LOG(LogLevel::DEBUG, msg)
+#define LOG_INFO(msg) JUPITER_LOG(LogLevel::INFO, msg)
+#define LOG_WARNING(msg) JUPITER_LOG(LogLevel::WARNING, msg)
+#define LOG_ERROR(msg) JUPITER_LOG(LogLevel::ERROR, msg)
+#define LOG_CRITICAL(msg) JUPITER_LOG(LogLevel::CRITICAL, msg)
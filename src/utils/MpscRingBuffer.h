@@ -0,0 +1,105 @@
+/**
+ * @file MpscRingBuffer.h
+ * @brief Bounded lock-free multi-producer single-consumer ring buffer
+ * @author piotrek-pl
+ * @date 2025-02-06 10:27:14
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * Bounded queue based on per-cell sequence numbers (D. Vyukov's design).
+ * Any number of threads may push concurrently; exactly one thread pops.
+ * push() never blocks - it returns false when the buffer is full and leaves
+ * the value untouched, so the caller can decide what to do with it.
+ */
+template <typename T>
+class MpscRingBuffer {
+public:
+    explicit MpscRingBuffer(std::size_t requestedCapacity)
+        : mask(roundUpToPowerOfTwo(requestedCapacity) - 1)
+        , cells(new Cell[mask + 1])
+        , enqueuePos(0)
+        , dequeuePos(0)
+    {
+        for (std::size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    bool push(T&& value)
+    {
+        Cell* cell;
+        std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;  // Bufor pełny
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Wywoływane wyłącznie przez jeden wątek konsumenta
+    bool pop(T& value)
+    {
+        const std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell = &cells[pos & mask];
+        const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1) < 0) {
+            return false;  // Bufor pusty
+        }
+
+        value = std::move(cell->value);
+        cell->value = T();
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    std::size_t capacity() const { return mask + 1; }
+
+    // Przybliżona liczba elementów - tylko do heurystyk
+    std::size_t approximateSize() const
+    {
+        const std::size_t head = dequeuePos.load(std::memory_order_relaxed);
+        const std::size_t tail = enqueuePos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t value)
+    {
+        std::size_t result = 2;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    const std::size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<std::size_t> enqueuePos;
+    alignas(64) std::atomic<std::size_t> dequeuePos;
+};
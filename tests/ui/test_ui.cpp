@@ -9,11 +9,44 @@
 #include <QApplication>
 #include "ui/LoginWindow.h"
 #include "ui/MainWindow.h"
+#include "ui/FriendsModel.h"
+#include "ui/StatusIconCache.h"
+#include "ui/SearchResultCache.h"
+#include "ui/SearchDialog.h"
+#include "ui/InvitationsDialog.h"
+#include "ui/InvitationStore.h"
+#include "ui/NotificationQueue.h"
+#include "ui/ChatWindowPool.h"
+#include "ui/HistoryPrefetcher.h"
+#include "ui/HistoryPageCache.h"
+#include "ui/HistoryPageSizer.h"
+#include "ui/ChatTranscriptModel.h"
+#include "ui/ChatMessageDelegate.h"
 #include <QLineEdit>
 #include <QPushButton>
 #include <QMenu>
 #include <QMenuBar>
 #include <QComboBox>
+#include <QListView>
+#include <QListWidget>
+#include <QAbstractItemModelTester>
+#include <optional>
+
+// Pierwsze zdarzenie Paint obserwowanego widgetu
+class FirstPaintProbe : public QObject
+{
+public:
+    bool painted = false;
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        if (event->type() == QEvent::Paint) {
+            painted = true;
+        }
+        return QObject::eventFilter(watched, event);
+    }
+};
 
 class UITests : public QObject
 {
@@ -208,7 +241,7 @@ private slots:
         QVERIFY2(centralWidget->isVisible(), "Central widget is not visible");
 
         // Test listy znajomych
-        QListWidget* friendsList = mainWindow->findChild<QListWidget*>("friendsList");
+        QListView* friendsList = mainWindow->findChild<QListView*>("friendsList");
         QVERIFY2(friendsList != nullptr, "Friends list not found");
         QVERIFY2(friendsList->isVisible(), "Friends list is not visible");
 
@@ -227,6 +260,576 @@ private slots:
         QAction* aboutAction = mainWindow->findChild<QAction*>("actionAbout");
         QVERIFY2(aboutAction != nullptr, "About action not found");
     }
+
+    void testFriendsModel()
+    {
+        FriendsModel model;
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+        QJsonArray friends;
+        auto addFriend = [&friends](int id, const QString& name, const QString& status) {
+            friends.append(QJsonObject{{"id", id}, {"username", name}, {"status", status}});
+        };
+        addFriend(1, "offline_1", Protocol::UserStatus::OFFLINE);
+        addFriend(2, "online_2", Protocol::UserStatus::ONLINE);
+        addFriend(3, "busy_3", Protocol::UserStatus::BUSY);
+        addFriend(4, "online_4", Protocol::UserStatus::ONLINE);
+        model.setFriends(friends);
+
+        // Kolejność: online, away, busy, offline
+        QCOMPARE(model.rowCount(), 4);
+        QCOMPARE(model.friendIdAt(0), 2);
+        QCOMPARE(model.friendIdAt(1), 4);
+        QCOMPARE(model.friendIdAt(2), 3);
+        QCOMPARE(model.friendIdAt(3), 1);
+
+        // Zmiana statusu przenosi tylko jeden wiersz
+        model.setStatus(1, Protocol::UserStatus::AWAY);
+        QCOMPARE(model.rowOf(1), 2);
+        QCOMPARE(model.rowOf(3), 3);
+        QCOMPARE(model.statusOf(1), Protocol::UserStatus::AWAY);
+
+        model.setStatus(2, Protocol::UserStatus::OFFLINE);
+        QCOMPARE(model.rowOf(2), 3);
+        QCOMPARE(model.rowOf(4), 0);
+
+        model.removeFriend(1);
+        QCOMPARE(model.rowCount(), 3);
+        QVERIFY(!model.contains(1));
+        for (int row = 0; row < model.rowCount(); ++row) {
+            QCOMPARE(model.rowOf(model.friendIdAt(row)), row);
+        }
+    }
+
+    void testFriendsModelDiff()
+    {
+        FriendsModel model;
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+        auto snapshot = [](const QList<QPair<int, QString>>& entries) {
+            QJsonArray friends;
+            for (const auto& entry : entries) {
+                friends.append(QJsonObject{{"id", entry.first},
+                                           {"username", QString("user_%1").arg(entry.first)},
+                                           {"status", entry.second}});
+            }
+            return friends;
+        };
+        const QString online = Protocol::UserStatus::ONLINE;
+        const QString offline = Protocol::UserStatus::OFFLINE;
+
+        model.applySnapshot(snapshot({{1, online}, {2, offline}, {3, offline}}));
+        QCOMPARE(model.rowCount(), 3);
+
+        // Niezmieniona lista - brak resetu i ruchów
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+        QSignalSpy moveSpy(&model, &QAbstractItemModel::rowsMoved);
+        model.applySnapshot(snapshot({{1, online}, {2, offline}, {3, offline}}));
+        QCOMPARE(resetSpy.count(), 0);
+        QCOMPARE(moveSpy.count(), 0);
+
+        // Jedna zmiana statusu, jedno usunięcie, jedno dodanie
+        QSignalSpy insertSpy(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy removeSpy(&model, &QAbstractItemModel::rowsRemoved);
+        model.applySnapshot(snapshot({{1, online}, {3, online}, {4, offline}}));
+        QCOMPARE(resetSpy.count(), 0);
+        QCOMPARE(insertSpy.count(), 1);
+        QCOMPARE(removeSpy.count(), 1);
+        QCOMPARE(model.friendIdAt(0), 1);
+        QCOMPARE(model.friendIdAt(1), 3);
+        QCOMPARE(model.friendIdAt(2), 4);
+
+        // Kompaktowa delta
+        model.applyDelta(Protocol::MessageStructure::createFriendsStatusDelta(
+            QJsonArray{QJsonObject{{"id", 1}, {"status", offline}}},
+            QJsonArray{QJsonObject{{"id", 5}, {"username", "user_5"}, {"status", online}}},
+            QJsonArray{3}));
+        QCOMPARE(model.rowCount(), 3);
+        QCOMPARE(model.friendIdAt(0), 5);
+        QCOMPARE(model.statusOf(1), offline);
+        QVERIFY(!model.contains(3));
+        for (int row = 0; row < model.rowCount(); ++row) {
+            QCOMPARE(model.rowOf(model.friendIdAt(row)), row);
+        }
+
+        // Powtórzone id - jeden wiersz, wygrywa ostatni wpis
+        model.applySnapshot(snapshot({{5, online}, {1, offline}, {5, offline}, {4, offline}}));
+        QCOMPARE(model.rowCount(), 3);
+        QCOMPARE(model.statusOf(5), offline);
+        QCOMPARE(model.friendIdAt(0), 1);
+        QCOMPARE(model.friendIdAt(1), 5);
+        QCOMPARE(model.friendIdAt(2), 4);
+
+        FriendsModel fresh;
+        fresh.setFriends(snapshot({{7, online}, {7, offline}}));
+        QCOMPARE(fresh.rowCount(), 1);
+        QCOMPARE(fresh.statusOf(7), offline);
+    }
+
+    void testChatTranscriptView()
+    {
+        QListView view;
+        view.resize(300, 200);
+        ChatTranscriptModel model;
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+        auto* delegate = new ChatMessageDelegate(&view);
+        view.setModel(&model);
+        view.setItemDelegate(delegate);
+
+        auto page = [](int first, int count) {
+            QList<ChatTranscriptModel::MessageRecord> batch;
+            for (int i = first; i < first + count; ++i) {
+                ChatTranscriptModel::MessageRecord record;
+                record.sender = "friend";
+                record.content = QString("message %1").arg(i);
+                record.timestamp = 1000 * i;
+                batch.append(record);
+            }
+            return batch;
+        };
+
+        model.appendMessages(page(100, 50));
+        model.prependMessages(page(50, 50));
+        QCOMPARE(model.rowCount(), 100);
+        QCOMPARE(model.recordAt(0).content, QString("message 50"));
+        QCOMPARE(model.recordAt(99).content, QString("message 149"));
+
+        // Wysokość liczona raz na wiadomość dla danej szerokości
+        QStyleOptionViewItem option;
+        option.initFrom(&view);
+        const QSize first = delegate->sizeHint(option, model.index(10));
+        const int cached = delegate->cachedLayouts();
+        QCOMPARE(delegate->sizeHint(option, model.index(10)), first);
+        QCOMPARE(delegate->cachedLayouts(), cached);
+
+        // Dodanie starszej strony nie unieważnia cache - klucze są stałe
+        model.prependMessages(page(0, 50));
+        QCOMPARE(delegate->sizeHint(option, model.index(60)), first);
+        QCOMPARE(delegate->cachedLayouts(), cached);
+    }
+
+    void testChatTranscriptEviction()
+    {
+        ChatTranscriptModel model;
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+        QList<ChatTranscriptModel::MessageRecord> batch;
+        for (int i = 0; i < 30; ++i) {
+            ChatTranscriptModel::MessageRecord record;
+            record.sender = "friend";
+            record.content = QString("message %1").arg(i);
+            batch.append(record);
+        }
+        model.appendMessages(batch);
+        const qint64 full = model.memoryUsage();
+        QVERIFY(full > 0);
+
+        // Klucze usuniętych wierszy trafiają do delegata (forget)
+        const QList<quint64> front = model.evictFront(10);
+        QCOMPARE(front.size(), 10);
+        QCOMPARE(front.first(), model.index(0).data(ChatTranscriptModel::KeyRole).toULongLong() - 10);
+        QCOMPARE(model.recordAt(0).content, QString("message 10"));
+
+        const QList<quint64> back = model.evictBack(5);
+        QCOMPARE(back.size(), 5);
+        QCOMPARE(model.rowCount(), 15);
+        QCOMPARE(model.recordAt(14).content, QString("message 24"));
+
+        qint64 expected = 0;
+        for (int row = 0; row < model.rowCount(); ++row) {
+            expected += ChatTranscriptModel::recordSize(model.recordAt(row));
+        }
+        QCOMPARE(model.memoryUsage(), expected);
+
+        model.evictFront(100);
+        QCOMPARE(model.rowCount(), 0);
+        QCOMPARE(model.memoryUsage(), qint64(0));
+    }
+
+    void testSearchResultCache()
+    {
+        auto user = [](const QString& name) { return QJsonObject{{"id", name}, {"username", name}}; };
+        SearchResultCache cache(2, 1000);
+
+        cache.insert("ann", QJsonArray{user("Anna"), user("Joanna"), user("Annika")}, true, 0);
+        QCOMPARE(cache.lookup("ANN", 10)->size(), 3);
+
+        // Dłuższe zapytanie zawężane lokalnie z kompletnego wyniku
+        std::optional<QJsonArray> narrowed = cache.narrow("anni", 20);
+        QVERIFY(narrowed.has_value());
+        QCOMPARE(narrowed->size(), 1);
+        QCOMPARE(narrowed->first().toObject()["username"].toString(), QString("Annika"));
+
+        // Wynik obcięty przez serwer nie nadaje się do zawężania
+        cache.insert("bob", QJsonArray{user("Bobby")}, false, 30);
+        QVERIFY(!cache.narrow("bobb", 40).has_value());
+
+        // LRU: najdawniej używane "ann" wypchnięte przez "bob"
+        QCOMPARE(cache.size(), 2);
+        QVERIFY(!cache.lookup("ann", 50).has_value());
+
+        // TTL
+        QVERIFY(cache.lookup("bob", 1030).has_value());
+        QVERIFY(!cache.lookup("bob", 1031).has_value());
+    }
+
+    void testSearchDialogDropsStaleResponses()
+    {
+        SearchDialog dialog(NetworkManager::getInstance());
+        QLineEdit* searchEdit = dialog.findChild<QLineEdit*>("searchEdit");
+        QListWidget* results = dialog.findChild<QListWidget*>("resultsList");
+        QVERIFY(searchEdit && results);
+
+        const QJsonArray users{QJsonObject{{"id", "42"}, {"username", "stale_test"}}};
+        searchEdit->setText("stale_test");
+        QVERIFY(QMetaObject::invokeMethod(&dialog, "performSearch"));
+
+        // Pierwsze zapytanie okna ma search_id 1
+        dialog.onSearchResponse(Protocol::MessageStructure::createSearchUsersResponse(users, 7));
+        QCOMPARE(results->count(), 0);
+        QCOMPARE(dialog.staleResponses(), quint64(1));
+
+        dialog.onSearchResponse(Protocol::MessageStructure::createSearchUsersResponse(users, 1));
+        QCOMPARE(results->count(), 1);
+
+        // Powtórzona odpowiedź - brak zapytania w toku
+        dialog.onSearchResponse(Protocol::MessageStructure::createSearchUsersResponse(users, 1));
+        QCOMPARE(dialog.staleResponses(), quint64(2));
+    }
+
+    void testInvitationStore()
+    {
+        using Kind = InvitationStore::Kind;
+        InvitationStore store;
+        QSignalSpy changed(&store, &InvitationStore::changed);
+
+        const QJsonArray sent{
+            QJsonObject{{"request_id", 1}, {"user_id", 10}, {"username", "ann"}, {"timestamp", 1000}},
+            QJsonObject{{"request_id", 2}, {"user_id", 20}, {"username", "bob"}, {"timestamp", 2000}}
+        };
+        QVERIFY(store.applyList(Kind::Sent, sent, 5));
+        QCOMPARE(store.invitations(Kind::Sent).size(), 2);
+        QCOMPARE(store.pendingUserIds(), QSet<int>({10, 20}));
+
+        // Ta sama wersja - bez przebudowy i bez sygnału
+        QVERIFY(!store.applyList(Kind::Sent, sent, 5));
+        QCOMPARE(changed.count(), 1);
+
+        // Zmiana lokalna unieważnia wersję
+        QVERIFY(store.removeByUserId(Kind::Sent, 10));
+        QCOMPARE(store.version(Kind::Sent), InvitationStore::NO_VERSION);
+        QVERIFY(!store.removeByRequestId(Kind::Sent, 1));
+        QVERIFY(store.invitations(Kind::Received).isEmpty());
+        QCOMPARE(changed.count(), 2);
+    }
+
+    void testInvitationRefreshCoalescing()
+    {
+        InvitationsDialog dialog(NetworkManager::getInstance());
+
+        for (int i = 0; i < 5; ++i) {
+            dialog.refreshInvitations();
+        }
+        QCoreApplication::processEvents();
+        QCOMPARE(dialog.refreshRequestCount(), quint64(1));
+
+        // Odświeżenie w trakcie oczekiwania na listy czeka na odpowiedzi
+        dialog.refreshInvitations();
+        QCoreApplication::processEvents();
+        QCOMPARE(dialog.refreshRequestCount(), quint64(1));
+
+        MessageRouter& router = NetworkManager::getInstance().router();
+        router.dispatch(Protocol::MessageType::Id::RECEIVED_INVITATIONS_RESPONSE,
+                        Protocol::MessageStructure::createReceivedInvitationsResponse(QJsonArray(), 3));
+        router.dispatch(Protocol::MessageType::Id::SENT_INVITATIONS_RESPONSE,
+                        Protocol::MessageStructure::createSentInvitationsResponse(QJsonArray(), 4));
+        QCoreApplication::processEvents();
+        QCOMPARE(dialog.refreshRequestCount(), quint64(2));
+        QCOMPARE(dialog.invitationStore().version(InvitationStore::Kind::Sent), qint64(4));
+    }
+
+    void testPromptDoesNotBlockFrames()
+    {
+        NotificationQueue& notifications = NotificationQueue::getInstance();
+        notifications.clear();
+        MessageRouter& router = NetworkManager::getInstance().router();
+
+        QObject receiver;
+        int pongs = 0;
+        router.subscribe(&receiver, Protocol::MessageType::Id::PONG,
+                         [&pongs](const QJsonObject&) { ++pongs; });
+
+        std::optional<bool> answer;
+        notifications.question(nullptr, "Prompt", "Continue?", &receiver,
+                               [&answer](bool accepted) { answer = accepted; });
+        QVERIFY(notifications.activeBox() != nullptr);
+
+        // Zaproszenie z sieci trafia do kolejki zamiast otwierać okno modalne
+        router.dispatch(Protocol::MessageType::Id::FRIEND_REQUEST_RECEIVED,
+                        QJsonObject{{"from_user_id", 77}, {"username", "prompt_test"}});
+        QCOMPARE(notifications.pendingCount(), 1);
+
+        // Ramki są obsługiwane, choć pytanie nadal czeka na odpowiedź
+        for (int i = 0; i < 3; ++i) {
+            router.dispatch(Protocol::MessageType::Id::PONG, QJsonObject{{"type", "pong"}});
+            QCoreApplication::processEvents();
+        }
+        QCOMPARE(pongs, 3);
+        QVERIFY(!answer.has_value());
+
+        notifications.activeBox()->button(QMessageBox::Yes)->click();
+        QCoreApplication::processEvents();
+        QCOMPARE(answer, std::optional<bool>(true));
+        QCOMPARE(notifications.activeBox()->text(),
+                 QString("prompt_test wants to add you to their friends list. Accept?"));
+
+        notifications.clear();
+        QVERIFY(notifications.activeBox() == nullptr);
+    }
+
+    void testChatWindowPool()
+    {
+        ChatWindowPool pool(1);
+        pool.warmUp();
+        QCOMPARE(pool.idleCount(), 1);
+
+        ChatWindow* first = pool.acquire("pool_ann", 501);
+        QCOMPARE(pool.reusedCount(), quint64(1));
+        QCOMPARE(first->boundFriendId(), 501);
+        QCOMPARE(first->windowTitle(), QString("Chat with pool_ann"));
+
+        // Pula pusta - kolejne okno budowane od zera
+        ChatWindow* second = pool.acquire("pool_bob", 502);
+        QCOMPARE(pool.createdCount(), quint64(2));
+
+        QSignalSpy closedSpy(first, &ChatWindow::closed);
+        first->show();
+        first->close();
+        QCOMPARE(closedSpy.count(), 1);
+        QCOMPARE(closedSpy.first().first().toInt(), 501);
+
+        pool.release(first);
+        QCOMPARE(first->boundFriendId(), int(ChatWindow::NO_FRIEND));
+        QCOMPARE(first->messageCount(), 0);
+        // Pula pełna - nadmiarowe okno jest usuwane
+        QPointer<ChatWindow> extra(second);
+        pool.release(second);
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        QVERIFY(extra.isNull());
+
+        QCOMPARE(pool.acquire("pool_cid", 503), first);
+        QCOMPARE(first->windowTitle(), QString("Chat with pool_cid"));
+        pool.release(first);
+    }
+
+    void testHistoryPrefetcher()
+    {
+        HistoryPrefetcher prefetcher;
+
+        // Przewijanie w górę 1 px/ms, 3000 px od góry listy
+        int value = 3200;
+        for (qint64 now = 0; now <= 200; now += 20, value -= 20) {
+            QVERIFY(!prefetcher.onScroll(value, now));
+        }
+        QVERIFY(prefetcher.velocity() < 0);
+        QCOMPARE(prefetcher.wantedPages(5000, 200), 0);
+        QCOMPARE(prefetcher.wantedPages(800, 200), 1);
+        QCOMPARE(prefetcher.wantedPages(200, 200), HistoryPrefetcher::MAX_PAGES);
+
+        // Zawrócenie w dół jest zgłaszane raz
+        bool reversed = false;
+        for (qint64 now = 220; now <= 400; now += 20, value += 40) {
+            reversed = prefetcher.onScroll(value, now) || reversed;
+        }
+        QVERIFY(reversed);
+        QCOMPARE(prefetcher.wantedPages(200, 200), 0);
+
+        // Skok po doklejeniu wierszy nie zmienia prędkości
+        const double velocity = prefetcher.velocity();
+        prefetcher.rebase(value + 5000, 410);
+        QCOMPARE(prefetcher.velocity(), velocity);
+
+        ChatTranscriptModel::MessageRecord record;
+        record.sender = "ann";
+        record.content = "older";
+        prefetcher.storePage(HistoryPrefetcher::Page{{record, record}, true});
+        prefetcher.storePage(HistoryPrefetcher::Page{{record}, false});
+        QCOMPARE(prefetcher.bufferedMessages(), 3);
+        QVERIFY(prefetcher.exhausted());
+
+        std::optional<HistoryPrefetcher::Page> page = prefetcher.takePage();
+        QVERIFY(page.has_value());
+        QCOMPARE(page->records.size(), 2);
+        QCOMPARE(prefetcher.bufferedPages(), 1);
+        prefetcher.clearPages();
+        QVERIFY(!prefetcher.takePage().has_value());
+    }
+
+    void testHistoryPageCache()
+    {
+        HistoryPageCache& cache = HistoryPageCache::getInstance();
+        cache.clear();
+
+        auto message = [](int n) {
+            ChatTranscriptModel::MessageRecord record;
+            record.sender = "ann";
+            record.content = QString("message %1").arg(n);
+            record.timestamp = 1000 * n;
+            return record;
+        };
+        const int friendId = 901;
+
+        // Najnowsze 5..9, starsze jeszcze nie pobrane
+        QList<ChatTranscriptModel::MessageRecord> latest;
+        for (int n = 5; n < 10; ++n) latest.append(message(n));
+        cache.storeLatest(friendId, latest, true);
+        QVERIFY(!cache.olderThan(friendId, message(5), 3).has_value());
+
+        // Strona przed kursorem 5, dokładnie przylega do fragmentu
+        cache.storeOlder(friendId, message(5), HistoryPageCache::Page{{message(3), message(4)}, true});
+        cache.storeOlder(friendId, message(9), HistoryPageCache::Page{{message(0)}, false});
+        QCOMPARE(cache.size(friendId), 7);
+
+        std::optional<HistoryPageCache::Page> older = cache.olderThan(friendId, message(7), 3);
+        QVERIFY(older.has_value());
+        QCOMPARE(older->records.size(), 3);
+        QCOMPARE(older->records.first().content, QString("message 4"));
+        QVERIFY(older->hasMore);
+
+        // Nowa wiadomość w śledzonej rozmowie
+        cache.append(friendId, message(10));
+        std::optional<HistoryPageCache::Page> newer = cache.newerThan(friendId, message(8), 5);
+        QVERIFY(newer.has_value());
+        QCOMPARE(newer->records.size(), 2);
+        QVERIFY(!newer->hasMore);
+        QCOMPARE(cache.latest(friendId, 2)->records.last().content, QString("message 10"));
+
+        // Po zerwaniu połączenia koniec fragmentu jest niepewny, starsze strony nie
+        cache.markAllStale();
+        QVERIFY(!cache.latest(friendId, 2).has_value());
+        QVERIFY(!cache.newerThan(friendId, message(10), 5).has_value());
+        QVERIFY(cache.olderThan(friendId, message(5), 2).has_value());
+        cache.append(friendId, message(11));
+        QCOMPARE(cache.size(friendId), 8);
+
+        // Strona najnowszych zachodzi na fragment - dopisywane tylko nowsze
+        cache.storeLatest(friendId, {message(9), message(10), message(11), message(12)}, true);
+        QCOMPARE(cache.size(friendId), 10);
+        QCOMPARE(cache.latest(friendId, 1)->records.first().content, QString("message 12"));
+
+        cache.clear();
+        QCOMPARE(cache.conversationCount(), 0);
+    }
+
+    void testHistoryPageSizer()
+    {
+        HistoryPageSizer::Inputs inputs;
+        inputs.viewportHeight = 400;
+        inputs.rowHeight = 40;
+        QCOMPARE(HistoryPageSizer::screenRows(inputs), 10);
+
+        // Bez pomiarów łącza - nie mniej niż dotychczasowa stała paczka
+        QCOMPARE(HistoryPageSizer::pageSize(inputs), Protocol::ChatHistory::MESSAGE_BATCH_SIZE);
+        // Wysoki ekran: pierwsza strona wypełnia widok z zapasem
+        inputs.viewportHeight = 2000;
+        QCOMPARE(HistoryPageSizer::pageSize(inputs), 100);
+
+        // Duże opóźnienie, szybkie łącze: tyle, ile mieści się w jednym RTT, do limitu
+        inputs.messageBytes = 200;
+        inputs.link.roundTripMs = 200;
+        inputs.link.bytesPerMs = 1000.0;
+        inputs.ceiling = 300;
+        QCOMPARE(HistoryPageSizer::pageSize(inputs), 300);
+
+        // Wolne łącze: tylko to, co widać
+        inputs.link.bytesPerMs = 2.0;
+        QCOMPARE(HistoryPageSizer::pageSize(inputs), 50);
+    }
+
+    // Otwarcie okna czatu do pierwszego odmalowania: nowe okno z własnym arkuszem vs pula
+    void benchmarkChatWindowOpen_data()
+    {
+        QTest::addColumn<bool>("pooled");
+        QTest::newRow("new") << false;
+        QTest::newRow("pool") << true;
+    }
+
+    void benchmarkChatWindowOpen()
+    {
+        QFETCH(bool, pooled);
+
+        QFile styleFile(":/resources/styles.qss");
+        QVERIFY(styleFile.open(QIODevice::ReadOnly));
+        const QString styleSheet = QString::fromUtf8(styleFile.readAll());
+        if (pooled) {
+            qApp->setStyleSheet(styleSheet);
+        }
+
+        const int iterations = 20;
+        ChatWindowPool pool(1);
+        pool.warmUp();
+        qint64 totalNs = 0;
+
+        for (int i = 0; i < iterations; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+
+            ChatWindow* window = nullptr;
+            if (pooled) {
+                window = pool.acquire("bench", 900);
+            } else {
+                // Dotychczasowe zachowanie: setupUi i arkusz stylów osobno dla każdego okna
+                window = new ChatWindow("bench", 900);
+                window->setStyleSheet(styleSheet);
+            }
+            FirstPaintProbe probe;
+            window->findChild<QListView*>("transcriptView")->viewport()->installEventFilter(&probe);
+            window->show();
+            while (!probe.painted && timer.elapsed() < 5000) {
+                QCoreApplication::processEvents();
+            }
+            totalNs += timer.nsecsElapsed();
+            QVERIFY(probe.painted);
+
+            window->findChild<QListView*>("transcriptView")->viewport()->removeEventFilter(&probe);
+            if (pooled) {
+                pool.release(window);
+            } else {
+                delete window;
+            }
+        }
+
+        qApp->setStyleSheet(QString());
+        QTest::setBenchmarkResult(qreal(totalNs) / iterations / 1e6, QTest::WalltimeMilliseconds);
+    }
+
+    // Przebudowa listy 2000 znajomych: ikona SVG na wiersz vs cache
+    void benchmarkFriendsListIcons_data()
+    {
+        QTest::addColumn<bool>("cached");
+        QTest::newRow("svg") << false;
+        QTest::newRow("cache") << true;
+    }
+
+    void benchmarkFriendsListIcons()
+    {
+        QFETCH(bool, cached);
+
+        StatusIconCache& icons = StatusIconCache::getInstance();
+        icons.warmUp({24}, 1.0);
+
+        QBENCHMARK {
+            for (int i = 0; i < 2000; ++i) {
+                const auto status = static_cast<FriendsModel::Status>(i % FriendsModel::STATUS_COUNT);
+                const bool unread = (i % 7 == 0);
+                QPixmap pixmap = cached
+                    ? icons.pixmap(status, unread, 24, 1.0)
+                    : QIcon(StatusIconCache::resourcePath(status, unread)).pixmap(24, 24);
+                QVERIFY(!pixmap.isNull());
+            }
+        }
+        QCOMPARE(icons.renderedCount(), FriendsModel::STATUS_COUNT * 2);
+    }
 };
 
 QTEST_MAIN(UITests)
@@ -0,0 +1,73 @@
+/**
+ * @file StandInServer.h
+ * @brief Local stand-in chat server for wire format benchmarks
+ * @author piotrek-pl
+ * @date 2025-02-04 20:15:32
+ */
+
+#pragma once
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QJsonObject>
+#include <memory>
+#include "network/FrameDecoder.h"
+#include "network/WireCodec.h"
+
+/**
+ * Answers every JSON request frame with a prepared response, encoded in the
+ * format named by the request's "format" field. Runs on its own thread so
+ * that a blocking client in the test thread measures a real round trip.
+ */
+class StandInServer {
+public:
+    explicit StandInServer(const QJsonObject& response)
+        : jsonResponse(WireCodec::encode(response, Protocol::WireFormat::Json))
+        , cborResponse(WireCodec::encode(response, Protocol::WireFormat::Cbor))
+        , server(new QTcpServer())
+    {
+        server->listen(QHostAddress::LocalHost);
+
+        QObject::connect(server, &QTcpServer::newConnection, server, [this]() {
+            while (QTcpSocket* client = server->nextPendingConnection()) {
+                auto decoder = std::make_shared<FrameDecoder>();
+                QObject::connect(client, &QTcpSocket::readyRead, client, [this, client, decoder]() {
+                    decoder->append(client->readAll());
+                    QByteArray frame;
+                    while (decoder->nextFrame(frame)) {
+                        QJsonObject request;
+                        QString errorString;
+                        if (!WireCodec::decode(frame, Protocol::WireFormat::Json, request, errorString)) {
+                            continue;
+                        }
+                        client->write(request["format"].toString() == "cbor" ? cborResponse
+                                                                               : jsonResponse);
+                    }
+                });
+            }
+        });
+
+        server->moveToThread(&thread);
+        thread.start();
+    }
+
+    ~StandInServer()
+    {
+        thread.quit();
+        thread.wait();
+        delete server;
+    }
+
+    quint16 port() const { return server->serverPort(); }
+    qsizetype responseSize(Protocol::WireFormat format) const
+    {
+        return format == Protocol::WireFormat::Cbor ? cborResponse.size() : jsonResponse.size();
+    }
+
+private:
+    const QByteArray jsonResponse;
+    const QByteArray cborResponse;
+    QTcpServer* server;
+    QThread thread;
+};
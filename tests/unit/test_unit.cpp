@@ -1,14 +1,48 @@
 #include <QtTest>
 #include <QCoreApplication>
 #include "network/Protocol.h"
+#include "network/FrameDecoder.h"
+#include "network/WireCodec.h"
+#include "network/MessageRouter.h"
+#include "network/PendingRequests.h"
+#include "network/ReadReceiptAggregator.h"
+#include "network/NetworkManager.h"
+#include "StandInServer.h"
 #include "config/ConfigManager.h"
 #include "utils/Logger.h"
+#include "utils/MpscRingBuffer.h"
+#include "storage/MessageStore.h"
+#include "storage/MessageSearchIndex.h"
 #include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QEventLoop>
+#include <QTimer>
+#include <functional>
+#include <vector>
 
 class UnitTests : public QObject
 {
     Q_OBJECT
 
+private:
+    static QJsonObject createHistoryPayload(int count)
+    {
+        QJsonArray messages;
+        for (int i = 0; i < count; ++i) {
+            messages.append(QJsonObject{
+                {"sender", i % 2 ? "alice" : "bob"},
+                {"content", QString("History message number %1 with some typical chat text").arg(i)},
+                {"timestamp", QDateTime::fromMSecsSinceEpoch(1738600000000 + i * 1000).toString(Qt::ISODate)},
+                {"is_read", true}
+            });
+        }
+        return QJsonObject{
+            {"type", Protocol::MessageType::CHAT_HISTORY_RESPONSE},
+            {"messages", messages},
+            {"has_more", true}
+        };
+    }
+
 private slots:
     void initTestCase()
     {
@@ -30,6 +64,11 @@ private slots:
         QCOMPARE(loginMsg["username"].toString(), "testuser");
         QVERIFY(loginMsg.contains("password"));
         QCOMPARE(loginMsg["protocol_version"].toInt(), 1);
+        QVERIFY(!loginMsg.contains("capabilities"));
+
+        QJsonObject cborLoginMsg = Protocol::MessageStructure::createLoginRequest(
+            "testuser", "password", {Protocol::Capabilities::CBOR});
+        QVERIFY(cborLoginMsg["capabilities"].toArray().contains(QJsonValue(Protocol::Capabilities::CBOR)));
 
         // Test wiadomości czatu
         QJsonObject chatMsg = Protocol::MessageStructure::createMessage(1, "Hello");
@@ -100,6 +139,634 @@ private slots:
         QRegularExpression timestampRegex("\\[\\d{4}-\\d{2}-\\d{2} \\d{2}:\\d{2}:\\d{2}\\.\\d{3}\\]");
         QVERIFY2(timestampRegex.match(logContent).hasMatch(), "Invalid timestamp format in log");
     }
+
+    // Test kolejki asynchronicznego loggera
+    void testMpscRingBuffer()
+    {
+        MpscRingBuffer<QString> queue(1000);
+        QCOMPARE(queue.capacity(), std::size_t(1024));
+
+        const int producers = 4;
+        const int perProducer = 20000;
+        std::vector<std::unique_ptr<QThread>> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back(QThread::create([&queue, p]() {
+                for (int i = 0; i < perProducer; ++i) {
+                    QString value = QString::number(p * perProducer + i);
+                    while (!queue.push(std::move(value))) {
+                        QThread::yieldCurrentThread();
+                    }
+                }
+            }));
+            threads.back()->start();
+        }
+
+        qint64 sum = 0;
+        int count = 0;
+        QString value;
+        while (count < producers * perProducer) {
+            if (queue.pop(value)) {
+                sum += value.toLongLong();
+                ++count;
+            }
+        }
+        for (auto& thread : threads) {
+            QVERIFY(thread->wait(5000));
+        }
+
+        const qint64 total = qint64(producers) * perProducer;
+        QCOMPARE(sum, total * (total - 1) / 2);
+        QVERIFY(!queue.pop(value));
+    }
+
+    void testLoggerFlush()
+    {
+        Logger& logger = Logger::getInstance();
+        QString testFile = "logs/unit_test_flush.log";
+        QFile::remove(testFile);
+        logger.setLogFile(testFile);
+
+        QString marker = QString("Flush marker %1").arg(QDateTime::currentMSecsSinceEpoch());
+        logger.warning(marker);
+        logger.flush();
+
+        // Po flush() wpis musi być w pliku niezależnie od trybu loggera
+        QFile logFile(testFile);
+        QVERIFY(logFile.open(QIODevice::ReadOnly | QIODevice::Text));
+        QVERIFY(QString::fromUtf8(logFile.readAll()).contains(marker));
+        QCOMPARE(logger.droppedRecords(), quint64(0));
+    }
+
+    void testMessageStore()
+    {
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        MessageStore& store = MessageStore::getInstance();
+        store.open(directory.path());
+
+        auto message = [](int i) {
+            return MessageStore::StoredMessage{i % 2 ? "me" : "friend", QString("wiadomość %1").arg(i),
+                                               1000LL * i, i % 2 == 1};
+        };
+
+        // Niezapisane jeszcze wiadomości są widoczne przy odczycie
+        for (int i = 0; i < 30; ++i) {
+            store.append(7, {message(i)});
+        }
+        QCOMPARE(store.readLatest(7, 100).size(), 30);
+
+        store.flush();
+        QList<MessageStore::StoredMessage> latest = store.readLatest(7, 10);
+        QCOMPARE(latest.size(), 10);
+        QCOMPARE(latest.first().content, QString("wiadomość 20"));
+        QCOMPARE(latest.last().timestamp, 29000LL);
+        QVERIFY(latest.last().isOwn);
+        QCOMPARE(latest.last().messageId, 0LL);
+        QVERIFY(store.committedBatches() <= quint64(30));
+        QCOMPARE(store.committedRecords(), quint64(30));
+
+        // Ponowne otwarcie czyta dane z dysku
+        store.close();
+        store.open(directory.path());
+        QCOMPARE(store.readLatest(7, 100).size(), 30);
+        QVERIFY(store.readLatest(8, 100).isEmpty());
+        store.flush();
+        QCOMPARE(store.searchIndex().indexedCount(7), qint64(30));
+        QCOMPARE(store.search("wiadomość 29", 5).first().message.timestamp, 29000LL);
+
+        MessageStore::StoredMessage withId = message(100);
+        withId.messageId = 4242;
+        store.reset(7, {withId});
+        QCOMPARE(store.readLatest(7, 100).size(), 1);
+        store.flush();
+        QCOMPARE(store.readLatest(7, 100).first().content, QString("wiadomość 100"));
+        QCOMPARE(store.readLatest(7, 100).first().messageId, 4242LL);
+        store.close();
+    }
+
+    void testMessageSearchIndex()
+    {
+        MessageSearchIndex index;
+        index.add(1, 0, "Spotkanie jutro o 10:00");
+        index.add(2, 0, "Jutro nie mogę, może w piątek?");
+        index.add(1, 1, "Piątek pasuje, spotkanie w biurze");
+        index.add(2, 1, "OK");
+
+        QCOMPARE(MessageSearchIndex::tokenize("Może w PIĄTEK?"),
+                 QStringList({"może", "w", "piątek"}));
+
+        // Prefiksy, wszystkie słowa muszą wystąpić, najnowsze najpierw
+        QList<MessageSearchIndex::Hit> hits = index.search("jut", 10);
+        QCOMPARE(hits.size(), 2);
+        QCOMPARE(hits[0].friendId, 2);
+        QCOMPARE(hits[1].friendId, 1);
+
+        hits = index.search("piąt spotk", 10);
+        QCOMPARE(hits.size(), 1);
+        QCOMPARE(hits[0].friendId, 1);
+        QCOMPARE(hits[0].sequence, qint64(1));
+
+        QCOMPARE(index.search("spotkanie", 1).size(), 1);
+        QVERIFY(index.search("kino", 10).isEmpty());
+
+        QTemporaryDir directory;
+        const QString path = directory.filePath("search.index");
+        QVERIFY(index.save(path));
+
+        MessageSearchIndex restored;
+        QVERIFY(restored.load(path));
+        QCOMPARE(restored.documentCount(), 4);
+        QCOMPARE(restored.indexedCount(1), qint64(2));
+        QCOMPARE(restored.search("pią", 10).size(), 2);
+
+        restored.removeConversation(1);
+        QCOMPARE(restored.search("pią", 10).size(), 1);
+        QCOMPARE(restored.indexedCount(1), qint64(0));
+
+        // Kompaktowanie usuwa dokumenty i puste listy, wyniki bez zmian
+        QCOMPARE(restored.removedCount(), 2);
+        const int tokensBefore = restored.tokenCount();
+        restored.compact();
+        QCOMPARE(restored.documentCount(), 2);
+        QCOMPARE(restored.removedCount(), 0);
+        QVERIFY(restored.tokenCount() < tokensBefore);
+        hits = restored.search("pią", 10);
+        QCOMPARE(hits.size(), 1);
+        QCOMPARE(hits[0].friendId, 2);
+        QCOMPARE(hits[0].sequence, qint64(0));
+        QCOMPARE(restored.search("ok", 10).first().sequence, qint64(1));
+        restored.add(3, 0, "piątek");
+        QCOMPARE(restored.search("piątek", 10).first().friendId, 3);
+
+        // Identyfikator spoza listy dokumentów - plik odrzucony, indeks do odbudowy z logów
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        const QByteArray header = file.read(2 * sizeof(quint32));  // Magia i wersja z poprawnego pliku
+        QVERIFY(file.resize(0) && file.seek(0));
+        QDataStream out(&file);
+        out.writeRawData(header.constData(), header.size());
+        out << quint32(1) << qint32(1) << qint64(0) << QHash<int, qint64>{{1, 1}}
+            << quint32(1) << QString("x") << quint32(1) << quint32(3) << QByteArray(1, char(3));
+        file.close();
+
+        MessageSearchIndex corrupt;
+        QVERIFY(!corrupt.load(path));
+        QCOMPARE(corrupt.documentCount(), 0);
+    }
+
+    // Koszt wyłączonego wpisu DEBUG: wywołanie metody vs makro
+    void benchmarkDisabledLogStatement_data()
+    {
+        QTest::addColumn<bool>("lazy");
+        QTest::newRow("eager") << false;
+        QTest::newRow("lazy") << true;
+    }
+
+    void benchmarkDisabledLogStatement()
+    {
+        QFETCH(bool, lazy);
+
+        Logger& logger = Logger::getInstance();
+        const LogLevel previousLevel = logger.logLevel();
+        logger.setLogLevel(LogLevel::WARNING);
+        QVERIFY(!logger.isEnabled(LogLevel::DEBUG));
+
+        const QByteArray frame = QJsonDocument(createHistoryPayload(5)).toJson(QJsonDocument::Compact);
+        if (lazy) {
+            QBENCHMARK {
+                LOG_DEBUG("Processing JSON: " + QString::fromUtf8(frame));
+            }
+        } else {
+            QBENCHMARK {
+                logger.debug("Processing JSON: " + QString::fromUtf8(frame));
+            }
+        }
+
+        logger.setLogLevel(previousLevel);
+    }
+
+    // Test dekodera ramek strumienia JSON
+    void testFrameDecoder()
+    {
+        FrameDecoder decoder;
+        QByteArray frame;
+
+        // Dwie ramki w jednym odczycie, oddzielone znakiem nowej linii
+        decoder.append("{\"type\":\"ping\"}\n{\"type\":\"pong\"}\n");
+        QVERIFY(decoder.nextFrame(frame));
+        QCOMPARE(frame, QByteArray("{\"type\":\"ping\"}"));
+        QVERIFY(decoder.nextFrame(frame));
+        QCOMPARE(frame, QByteArray("{\"type\":\"pong\"}"));
+        QVERIFY(!decoder.nextFrame(frame));
+
+        // Nawiasy i escapowane cudzysłowy wewnątrz stringów
+        QByteArray tricky = "{\"content\":\"a } b { \\\" } c\",\"n\":{\"x\":1}}";
+        decoder.append(tricky);
+        QVERIFY(decoder.nextFrame(frame));
+        QCOMPARE(frame, tricky);
+        QJsonParseError error;
+        QJsonDocument::fromJson(frame, &error);
+        QCOMPARE(error.error, QJsonParseError::NoError);
+
+        // Ramka podzielona na wiele odczytów, także w środku sekwencji escape
+        QByteArray split = "{\"content\":\"x\\\"}\"}";
+        for (char c : split) {
+            QVERIFY(!decoder.nextFrame(frame));
+            decoder.append(QByteArray(1, c));
+        }
+        QVERIFY(decoder.nextFrame(frame));
+        QCOMPARE(frame, split);
+        QCOMPARE(decoder.bufferedBytes(), qsizetype(0));
+    }
+
+    void testFrameDecoderCompaction()
+    {
+        FrameDecoder decoder(16);
+        QByteArray message = "{\"type\":\"new_messages\",\"content\":\"hello\"}";
+        QByteArray frame;
+
+        for (int i = 0; i < 100; ++i) {
+            // Niepełna ramka pozostaje w buforze pomiędzy kompaktowaniami
+            decoder.append(message + message.left(10));
+            QVERIFY(decoder.nextFrame(frame));
+            QCOMPARE(frame, message);
+            decoder.append(message.mid(10));
+            QVERIFY(decoder.nextFrame(frame));
+            QCOMPARE(frame, message);
+        }
+        QCOMPARE(decoder.bufferedBytes(), qsizetype(0));
+    }
+
+    void benchmarkFrameDecoderBurst()
+    {
+        QByteArray burst;
+        for (int i = 0; i < 5000; ++i) {
+            QJsonObject message = Protocol::MessageStructure::createNewMessage(
+                QString("message {%1} with \"braces\"").arg(i), 42, 1738600000000 + i);
+            burst += QJsonDocument(message).toJson(QJsonDocument::Compact);
+            burst += '\n';
+        }
+
+        QBENCHMARK {
+            FrameDecoder decoder;
+            decoder.append(burst);
+            QByteArray frame;
+            int frames = 0;
+            while (decoder.nextFrame(frame)) ++frames;
+            QCOMPARE(frames, 5000);
+        }
+    }
+
+    // Test kodeka formatu łącza
+    void testWireCodecRoundTrip()
+    {
+        QJsonObject payload = createHistoryPayload(50);
+
+        for (auto format : {Protocol::WireFormat::Json, Protocol::WireFormat::Cbor}) {
+            FrameDecoder decoder;
+            decoder.setMode(WireCodec::decoderModeFor(format));
+
+            // Dwie ramki, druga dostarczona w dwóch kawałkach
+            QByteArray encoded = WireCodec::encode(payload, format);
+            decoder.append(encoded + encoded.left(7));
+
+            QByteArray frame;
+            QJsonObject decoded;
+            QString errorString;
+            QVERIFY(decoder.nextFrame(frame));
+            QVERIFY2(WireCodec::decode(frame, format, decoded, errorString), qPrintable(errorString));
+            QCOMPARE(decoded, payload);
+
+            QVERIFY(!decoder.nextFrame(frame));
+            decoder.append(encoded.mid(7));
+            QVERIFY(decoder.nextFrame(frame));
+            QVERIFY(WireCodec::decode(frame, format, decoded, errorString));
+            QCOMPARE(decoded, payload);
+        }
+
+        QVERIFY(WireCodec::encode(payload, Protocol::WireFormat::Cbor).size() <
+                WireCodec::encode(payload, Protocol::WireFormat::Json).size());
+    }
+
+    void testWireFormatSwitch()
+    {
+        // login_response w JSON, dalej CBOR - '\n' po pierwszej ramce nie jest prefiksem długości
+        const QJsonObject login{{"type", Protocol::MessageType::LOGIN_RESPONSE}, {"status", "success"}};
+        const QJsonObject payload = createHistoryPayload(5);
+        const QByteArray json = WireCodec::encode(login, Protocol::WireFormat::Json);
+        const QByteArray cbor = WireCodec::encode(payload, Protocol::WireFormat::Cbor);
+        QVERIFY(json.endsWith('\n'));
+
+        const QList<QList<QByteArray>> deliveries = {
+            {json + cbor},                                      // Jeden odczyt
+            {json.chopped(1), QByteArray("\n") + cbor},         // Separator w kolejnym odczycie
+            {json.chopped(1), QByteArray("\r\n"), cbor.left(3), cbor.mid(3)}
+        };
+        for (const QList<QByteArray>& chunks : deliveries) {
+            FrameDecoder decoder;
+            QByteArray frame;
+            QJsonObject decoded;
+            QString errorString;
+            qsizetype next = 0;
+
+            while (!decoder.nextFrame(frame)) {
+                decoder.append(chunks[next++]);
+            }
+            QVERIFY(WireCodec::decode(frame, Protocol::WireFormat::Json, decoded, errorString));
+            QCOMPARE(decoded, login);
+
+            decoder.setMode(WireCodec::decoderModeFor(Protocol::WireFormat::Cbor));
+            while (!decoder.nextFrame(frame)) {
+                QVERIFY(!decoder.isCorrupted());
+                QVERIFY(next < chunks.size());
+                decoder.append(chunks[next++]);
+            }
+            QVERIFY(!decoder.isCorrupted());
+            QVERIFY2(WireCodec::decode(frame, Protocol::WireFormat::Cbor, decoded, errorString),
+                     qPrintable(errorString));
+            QCOMPARE(decoded, payload);
+            QCOMPARE(decoder.bufferedBytes(), qsizetype(0));
+        }
+    }
+
+    // Test dekodowania typu wiadomości i routera
+    void testMessageTypeLookup()
+    {
+        using namespace Protocol::MessageType;
+
+        for (const Entry& entry : TABLE) {
+            QCOMPARE(fromString(QString(toString(entry.id))), entry.id);
+        }
+        QCOMPARE(fromString(NEW_MESSAGES), Id::NEW_MESSAGES);
+        QCOMPARE(fromString(INVITATION_STATUS_CHANGED), Id::INVITATION_STATUS_CHANGED);
+        QCOMPARE(fromString(QString()), Id::UNKNOWN);
+        QCOMPARE(fromString(QStringLiteral("new_message")), Id::UNKNOWN);
+        QCOMPARE(fromString(QStringLiteral("new_messagesx")), Id::UNKNOWN);
+    }
+
+    void testMessageRouter()
+    {
+        using Protocol::MessageType::Id;
+
+        MessageRouter router;
+        int newMessages = 0;
+        int responses = 0;
+        {
+            QObject subscriber;
+            router.subscribe(&subscriber, Id::NEW_MESSAGES, [&](const QJsonObject&) { ++newMessages; });
+            router.subscribe(&subscriber, Id::MESSAGE_RESPONSE, [&](const QJsonObject&) { ++responses; });
+
+            router.dispatch(Id::NEW_MESSAGES, QJsonObject());
+            router.dispatch(Id::PING, QJsonObject());
+            QCOMPARE(newMessages, 1);
+            QCOMPARE(responses, 0);
+        }
+
+        // Subskrypcje zniszczonego obiektu nie są już wywoływane
+        router.dispatch(Id::NEW_MESSAGES, QJsonObject());
+        QCOMPARE(newMessages, 1);
+        QCOMPARE(router.droppedCount(), quint64(2));
+    }
+
+    void testPendingRequests()
+    {
+        using Protocol::MessageType::Id;
+
+        PendingRequests requests(5);
+        QList<int> answered;
+        QList<int> failed;
+        auto historyRequest = [&](int requestId, int friendId, int timeoutMs) {
+            requests.add(QJsonObject{{"type", "get_more_history"}, {"friend_id", friendId}, {"req_id", requestId}},
+                         Id::MORE_HISTORY_RESPONSE, nullptr,
+                         [&answered, requestId](const QJsonObject&) { answered.append(requestId); },
+                         [&failed, requestId]() { failed.append(requestId); }, timeoutMs);
+        };
+
+        // Dwa żądania tego samego typu rozróżniane po req_id
+        historyRequest(1, 5, 5000);
+        historyRequest(2, 6, 5000);
+        QVERIFY(requests.complete(Id::MORE_HISTORY_RESPONSE,
+                                  QJsonObject{{"friend_id", 5}, {"req_id", 2}}));
+        QCOMPARE(answered, QList<int>({2}));
+
+        // Serwer bez req_id - dopasowanie po rozmówcy
+        historyRequest(3, 7, 5000);
+        QVERIFY(requests.complete(Id::MORE_HISTORY_RESPONSE, QJsonObject{{"friend_id", 7}}));
+        QVERIFY(!requests.complete(Id::MORE_HISTORY_RESPONSE, QJsonObject{{"friend_id", 7}}));
+        QCOMPARE(answered, QList<int>({2, 3}));
+        QCOMPARE(requests.latency(Id::GET_MORE_HISTORY).samples, 2);
+
+        // Błąd serwera z req_id kończy żądanie niepowodzeniem
+        QVERIFY(requests.complete(Id::ERROR, QJsonObject{{"req_id", 1}}));
+        QCOMPARE(failed, QList<int>({1}));
+
+        // Termin dłuższy niż jeden obrót koła (128 * 5 ms)
+        historyRequest(4, 5, 900);
+        QTest::qWait(300);
+        QCOMPARE(failed, QList<int>({1}));
+        QTRY_COMPARE(failed, QList<int>({1, 4}));
+        QCOMPARE(requests.timedOutCount(), quint64(1));
+        QCOMPARE(requests.pendingCount(), 0);
+
+        // Anulowane żądania kontekstu nie wywołują callbacków
+        QObject context;
+        requests.add(QJsonObject{{"type", "get_latest_messages"}, {"req_id", 5}},
+                     Id::LATEST_MESSAGES_RESPONSE, &context,
+                     [&answered](const QJsonObject&) { answered.append(5); }, nullptr, 5000);
+        requests.cancel(&context);
+        QVERIFY(!requests.complete(Id::LATEST_MESSAGES_RESPONSE, QJsonObject{{"req_id", 5}}));
+        QCOMPARE(requests.pendingCount(), 0);
+    }
+
+    void testTransferEstimate()
+    {
+        // 100 ms stałego kosztu + 50 B/ms
+        const std::vector<qint64> bytes{1000, 5000, 10000, 20000};
+        std::vector<qint64> latencies;
+        for (qint64 size : bytes) latencies.push_back(100 + size / 50);
+
+        PendingRequests::TransferStats stats = PendingRequests::fitTransfer(latencies, bytes);
+        QCOMPARE(stats.samples, 4);
+        QCOMPARE(stats.roundTripMs, qint64(100));
+        QVERIFY(qAbs(stats.bytesPerMs - 50.0) < 0.01);
+
+        // Odpowiedzi tej samej wielkości - przepustowość nieznana
+        stats = PendingRequests::fitTransfer({120, 130, 110, 120}, {4000, 4000, 4000, 4000});
+        QCOMPARE(stats.bytesPerMs, 0.0);
+        QCOMPARE(stats.roundTripMs, qint64(120));
+    }
+
+    void testReadReceiptAggregator()
+    {
+        QList<QJsonObject> frames;
+        ReadReceiptAggregator receipts([&frames](const QJsonObject& message) { frames.append(message); }, 200);
+
+        // Otwarcie okna zgłasza odczyt kilka razy - jedna ramka
+        QVERIFY(receipts.markRead(1, 1000));
+        QVERIFY(!receipts.markRead(1, 1000));
+        QVERIFY(!receipts.markRead(1, 900));
+        QVERIFY(frames.isEmpty());
+        QTRY_COMPARE(frames.size(), 1);
+        QCOMPARE(frames[0]["friendId"].toInt(), 1);
+        QCOMPARE(frames[0]["read_until"].toInteger(), qint64(1000));
+        QCOMPARE(receipts.suppressedCount(), quint64(2));
+
+        // Kolejne przesunięcia w obrębie interwału - jedna ramka z najwyższym znacznikiem
+        QVERIFY(receipts.markRead(1, 2000));
+        QVERIFY(receipts.markRead(1, 3000));
+        QTest::qWait(50);
+        QCOMPARE(frames.size(), 1);
+        QTRY_COMPARE(frames.size(), 2);
+        QCOMPARE(frames[1]["read_until"].toInteger(), qint64(3000));
+
+        // Serwer z READ_BATCH - wszystkie rozmowy w jednej ramce
+        receipts.setBatched(true);
+        receipts.markRead(2, 500);
+        receipts.markRead(3, 700);
+        receipts.flush();
+        QCOMPARE(frames.size(), 3);
+        QCOMPARE(frames[2]["reads"].toArray().size(), 2);
+        QCOMPARE(receipts.readMark(3), qint64(700));
+        QCOMPARE(receipts.pendingCount(), 0);
+    }
+
+    void testOutboundWrites()
+    {
+        StandInServer server(createHistoryPayload(1));
+        NetworkManager& network = NetworkManager::getInstance();
+        network.connectToServer("127.0.0.1", server.port());
+        QTRY_VERIFY_WITH_TIMEOUT(network.isConnected(), 5000);
+
+        // Wysyłki wewnątrz pętli zdarzeń (jak w aplikacji), nie z samego testu
+        QEventLoop loop;
+        auto inEventLoop = [&loop](std::function<void()> task) {
+            QTimer::singleShot(0, &loop, [&loop, task]() {
+                task();
+                loop.quit();
+            });
+            loop.exec();
+        };
+
+        // Wiadomości z jednego przebiegu pętli - jeden zapis do gniazda
+        const int count = 20;
+        const NetworkManager::WriteStats before = network.writeStats();
+        inEventLoop([&network, count]() {
+            for (int i = 0; i < count; ++i) {
+                network.sendMessage(Protocol::MessageStructure::createMessageRead(7));
+            }
+        });
+        QTRY_COMPARE(network.writeStats().socketWrites - before.socketWrites, quint64(1));
+        QCOMPARE(network.writeStats().messagesQueued - before.messagesQueued, quint64(count));
+
+        // FlushNow zapisuje przed powrotem z sendMessage
+        const quint64 writesBefore = network.writeStats().socketWrites;
+        quint64 writesAfterSend = 0;
+        inEventLoop([&network, &writesAfterSend]() {
+            network.sendMessage(Protocol::MessageStructure::createLogoutRequest(),
+                                NetworkManager::FlushMode::FlushNow);
+            writesAfterSend = network.writeStats().socketWrites;
+        });
+        QCOMPARE(writesAfterSend - writesBefore, quint64(1));
+
+        // Backpressure włącza się na górnym progu i wyłącza na dolnym
+        const ConfigManager::ConnectionConfig config = ConfigManager::getInstance().getConnectionConfig();
+        const QString chunk(8 * 1024, QChar('x'));
+        const qint64 chunks = config.writeHighWatermark / chunk.size() + 8;
+        QSignalSpy backpressure(&network, &NetworkManager::writeBackpressureChanged);
+        bool onAfterSend = false;
+        inEventLoop([&network, &onAfterSend, &chunk, chunks]() {
+            for (qint64 i = 0; i < chunks; ++i) {
+                network.sendMessage(QJsonObject{{"type", Protocol::MessageType::SEND_MESSAGE},
+                                                {"content", chunk}});
+            }
+            onAfterSend = network.isWriteBackpressured();
+        });
+        QVERIFY(onAfterSend);
+        QVERIFY(!backpressure.isEmpty());
+        QVERIFY(backpressure.at(0).at(0).toBool());
+
+        QTRY_COMPARE_WITH_TIMEOUT(backpressure.count(), 2, 5000);
+        QVERIFY(!backpressure.at(1).at(0).toBool());
+        QVERIFY(network.bytesToWrite() <= config.writeLowWatermark);
+
+        network.disconnectFromServer();
+    }
+
+    void testMessageRouterPeerRouting()
+    {
+        using Protocol::MessageType::Id;
+
+        MessageRouter router;
+        QObject firstChat;
+        QObject secondChat;
+        int first = 0;
+        int second = 0;
+        router.subscribePeer(&firstChat, Id::NEW_MESSAGES, 1, [&](const QJsonObject&) { ++first; });
+        router.subscribePeer(&secondChat, Id::NEW_MESSAGES, 2, [&](const QJsonObject&) { ++second; });
+        router.subscribePeer(&secondChat, Id::LATEST_MESSAGES_RESPONSE, 2, [&](const QJsonObject&) { ++second; });
+
+        router.dispatch(Id::NEW_MESSAGES, QJsonObject{{"from", 2}});
+        QCOMPARE(first, 0);
+        QCOMPARE(second, 1);
+
+        router.dispatch(Id::LATEST_MESSAGES_RESPONSE, QJsonObject{{"friend_id", 2}});
+        QCOMPARE(second, 2);
+
+        // Nieznany rozmówca - ramka odrzucona
+        router.dispatch(Id::NEW_MESSAGES, QJsonObject{{"from", 3}});
+        QCOMPARE(router.droppedCount(), quint64(1));
+
+        // Bez identyfikatora rozmówcy - wszyscy subskrybenci typu
+        router.dispatch(Id::NEW_MESSAGES, QJsonObject());
+        QCOMPARE(first, 1);
+        QCOMPARE(second, 3);
+        QCOMPARE(router.deliveredCount(), quint64(4));
+    }
+
+    void benchmarkWireFormatRoundTrip_data()
+    {
+        QTest::addColumn<bool>("cbor");
+        QTest::newRow("json") << false;
+        QTest::newRow("cbor") << true;
+    }
+
+    void benchmarkWireFormatRoundTrip()
+    {
+        QFETCH(bool, cbor);
+        const auto format = cbor ? Protocol::WireFormat::Cbor : Protocol::WireFormat::Json;
+
+        StandInServer server(createHistoryPayload(200));
+        QTcpSocket client;
+        client.connectToHost(QHostAddress::LocalHost, server.port());
+        QVERIFY(client.waitForConnected(1000));
+
+        QByteArray request = WireCodec::encode(QJsonObject{
+            {"type", Protocol::MessageType::GET_CHAT_HISTORY},
+            {"format", cbor ? "cbor" : "json"}
+        }, Protocol::WireFormat::Json);
+
+        FrameDecoder decoder;
+        decoder.setMode(WireCodec::decoderModeFor(format));
+
+        QBENCHMARK {
+            client.write(request);
+            client.flush();
+
+            QByteArray frame;
+            while (!decoder.nextFrame(frame)) {
+                QVERIFY(client.waitForReadyRead(5000));
+                decoder.append(client.readAll());
+            }
+
+            QJsonObject response;
+            QString errorString;
+            QVERIFY(WireCodec::decode(frame, format, response, errorString));
+            QCOMPARE(response["messages"].toArray().size(), 200);
+        }
+
+        QVERIFY(server.responseSize(Protocol::WireFormat::Cbor)
+                < server.responseSize(Protocol::WireFormat::Json));
+    }
 };
 
 QTEST_MAIN(UnitTests)